@@ -0,0 +1,180 @@
+/*
+ * This sketch measures how many I²C transactions, bytes and how much CPU time the library uses for some common workloads.
+ *
+ * It runs against bq25186_simulator so no BQ25186 is needed, on any board or on a host machine. The results are printed as CSV
+ * and compared with the limits in the table below, anything more than BENCHMARK_TOLERANCE_PERCENT over a limit is a regression.
+ *
+ * To build and run it on a host, where it exits with 1 on a regression...
+ *
+ * g++ -std=gnu++11 -x c++ examples/benchmark/benchmark.ino -x none src/bq25186*.cpp -Isrc -o benchmark && ./benchmark
+ *
+ * Only the transactions and bytes are checked against the limits, the time depends on the machine so is just reported.
+ *
+ */
+
+#include <bq25186.h>  //Include the BQ25186 library
+#include <bq25186_simulator.h>  //Include the simulated BQ25186
+#include <stdio.h>  //For snprintf()
+
+#define BENCHMARK_ITERATIONS 100        //Calls of each case
+#define BENCHMARK_TOLERANCE_PERCENT 10  //How far over a limit counts as a regression
+
+bq25186_simulator simulator;  //Stands in for the charger and counts every transaction
+bq25186 charger;              //Create a new instance of the charger object
+uint16_t iteration = 0;       //Which call of the current case this is
+
+struct benchmarkCase {
+  const char *kind;           //"workload" for a sequence of calls an application might make, "api" for a single call
+  const char *name;
+  void (*prepare)();          //Run before each call, not timed or counted
+  void (*run)();              //The timed and counted call
+  uint32_t transactions;      //Limits for BENCHMARK_ITERATIONS calls
+  uint32_t bytes;             //Written and read
+};
+
+void noPreparation() {
+}
+void coldCache() {            //As if the values had never been read
+  charger.invalidate_cache();
+}
+void statusExpired() {        //As if the status cache TTL had passed, eg. polling once a second
+  charger.invalidate_status_cache();
+}
+void powerUp() {              //The charger as it is after power up
+  simulator.reset();
+}
+void faultPending() {
+  charger.invalidate_status_cache();
+  if(iteration % 10 == 0) {   //A fault every ten polls
+    simulator.raise_flags(0x02, BQ25186_VIN_OVP_FAULT_DETECTED);
+  }
+}
+
+void monitoringReport() {     //What the monitoring example reads for each report
+  bq25186_status status;
+  bq25186_config config;
+  charger.read_status(status);
+  charger.read_config(config);
+}
+void bootConfig() {           //Start the charger and configure charging, as in set_charging_values
+  charger.begin(simulator);
+  charger.begin_config();
+  charger.set_ichg(200);
+  charger.set_vbatreg_mv(4200);
+  charger.set_iterm(BQ25186_ITERM_10_PERCENT);
+  charger.set_buvlo_mv(3000);
+  charger.set_ilim_ma(500);
+  charger.commit();
+}
+void statusPoll() {           //Individual status getters, as many sketches use them
+  charger.chg_stat();
+  charger.vin_pgood_stat();
+  charger.ilim_active_stat();
+  charger.vindpm_active_stat();
+  charger.ts_stat();
+}
+void faultPoll() {
+  charger.ts_fault();
+  charger.vin_ovp_fault_flag();
+  charger.buvlo_fault_flag();
+  charger.bat_ocp_fault();
+  charger.take_faults();
+}
+void getIlim() {
+  charger.get_ilim();
+}
+void setIlim() {
+  charger.set_ilim_ma(iteration % 2 ? 500 : 200);  //Alternate so every call is a change
+}
+void chgStat() {
+  charger.chg_stat();
+}
+void setVbatreg() {
+  charger.set_vbatreg_mv(iteration % 2 ? 4200 : 4100);
+}
+void readStatus() {
+  bq25186_status status;
+  charger.read_status(status);
+}
+void readConfig() {
+  bq25186_config config;
+  charger.read_config(config);
+}
+void getRegisters() {
+  uint8_t registers[0x0d];
+  charger.get_registers(0x00, sizeof(registers), registers);
+}
+
+const benchmarkCase benchmarkCases[] = {
+  {"workload", "monitoring_report", statusExpired, monitoringReport, 200, 400},
+  {"workload", "boot_config", powerUp, bootConfig, 400, 2100},
+  {"workload", "status_poll_1hz", statusExpired, statusPoll, 200, 400},
+  {"workload", "fault_poll", faultPending, faultPoll, 200, 400},
+  {"api", "get_ilim_cold", coldCache, getIlim, 200, 200},
+  {"api", "get_ilim_cached", noPreparation, getIlim, 0, 0},
+  {"api", "set_ilim_ma", noPreparation, setIlim, 100, 200},
+  {"api", "chg_stat_expired", statusExpired, chgStat, 200, 400},
+  {"api", "set_vbatreg_mv", noPreparation, setVbatreg, 100, 200},
+  {"api", "read_status_expired", statusExpired, readStatus, 200, 400},
+  {"api", "read_config_cold", coldCache, readConfig, 200, 1100},
+  {"api", "get_registers_cold", coldCache, getRegisters, 200, 1400},
+};
+
+void report(const char *line) {
+  #if defined(ARDUINO)
+  Serial.println(line);
+  #else
+  puts(line);
+  #endif
+}
+bool withinLimit(uint32_t measured, uint32_t limit) {
+  return measured * 100 <= limit * (100 + BENCHMARK_TOLERANCE_PERCENT);
+}
+bool runBenchmarks() {      //Returns false if any case is over its limits
+  char line[128];
+  bool passed = true;
+  report("kind,name,iterations,transactions,bytes_written,bytes_read,total_us,limit_transactions,limit_bytes,result");
+  for(uint8_t index = 0; index < sizeof(benchmarkCases) / sizeof(benchmarkCases[0]); index++) {
+    const benchmarkCase &benchmark = benchmarkCases[index];
+    simulator.reset();
+    charger.begin(simulator);
+    uint32_t transactions = 0;
+    uint32_t bytesWritten = 0;
+    uint32_t bytesRead = 0;
+    uint32_t totalTime = 0;
+    for(iteration = 0; iteration < BENCHMARK_ITERATIONS; iteration++) {
+      benchmark.prepare();
+      simulator.reset_counters();
+      uint32_t startTime = micros();
+      benchmark.run();
+      totalTime += micros() - startTime;
+      transactions += simulator.transactions();
+      bytesWritten += simulator.bytes_written();
+      bytesRead += simulator.bytes_read();
+    }
+    bool casePassed = withinLimit(transactions, benchmark.transactions) && withinLimit(bytesWritten + bytesRead, benchmark.bytes);
+    passed = passed && casePassed;
+    snprintf(line, sizeof(line), "%s,%s,%u,%lu,%lu,%lu,%lu,%lu,%lu,%s", benchmark.kind, benchmark.name, BENCHMARK_ITERATIONS,
+      (unsigned long)transactions, (unsigned long)bytesWritten, (unsigned long)bytesRead, (unsigned long)totalTime,
+      (unsigned long)benchmark.transactions, (unsigned long)benchmark.bytes, casePassed ? "pass" : "REGRESSION");
+    report(line);
+  }
+  report(passed ? "benchmark,pass" : "benchmark,REGRESSION");
+  return passed;
+}
+
+#if defined(ARDUINO)
+void setup() {
+  Serial.begin(115200);     //Set up the Serial for output
+  while(!Serial){}          //Wait for Serial to start, only needed on some boards
+  delay(5000);              //Give a USB connection time to come up
+  runBenchmarks();
+}
+
+void loop() {
+}
+#else
+int main() {
+  return runBenchmarks() ? 0 : 1;
+}
+#endif
@@ -30,108 +30,78 @@ void setup() {
 void loop() {
   if(millis() - loopTimer > 10e3) { //Query the charger every 10s
     loopTimer = millis();           //Avoiding using delay()
+    bq25186_status status;          //Decoded copies of the registers
+    bq25186_config config;
+    if(charger.read_status(status) == false || charger.read_config(config) == false) {  //Read everything needed for the report in as few I²C transactions as possible
+      Serial.println("Unable to read charger registers");
+      return;
+    }
     //Power good
     Serial.print("\r\nCharging\r\nPower in good:");
-    printTrueFalse(charger.vin_pgood_stat() == BQ25186_POWER_GOOD);
+    printTrueFalse(status.vin_pgood);
     Serial.print("\t");
     //VIN monitoring
     Serial.print("Charging VINDPM low threshold:");
-    if(charger.get_vindpm() == BQ25186_VINDPM_DISABLED) {
-      Serial.print("disabled");
-    } else if(charger.get_vindpm() == BQ25186_VINDPM_4_7) {
-      Serial.print("4.7V");
-    } else if(charger.get_vindpm() == BQ25186_VINDPM_4_5) {
-      Serial.print("4.5V");
-    } else if(charger.get_vindpm() == BQ25186_VINDPM_VBAT_PLUS_300) {
-      Serial.print("battery+300mV");
-    } else {
-      Serial.print("unknown");
-    }
+    Serial.print(bq25186::to_text(bq25186_units::vindpm, config.vindpm)); //Shared lookup tables in the library turn field values into text or units
+    Serial.print("\t");
+    //Input current limit
+    Serial.print("Input current limit:");
+    Serial.print(bq25186::to_text(bq25186_units::ilim, config.ilim));
     Serial.print("\t");
     //Charging enabled
     Serial.print("Charging enabled:");
-    printTrueFalse(charger.get_chg_dis()==false); //This is inverted because it's a 'disabled' flag
+    printTrueFalse(config.chg_dis == BQ25186_CHG_ENABLED); //This is inverted because it's a 'disabled' flag
     Serial.print("\t");
     //Charging
     Serial.print("Charging state:");
-    if(charger.chg_stat() == BQ25186_ENABLED_BUT_NOT_CHARGING) {
+    if(status.chg_stat == BQ25186_ENABLED_BUT_NOT_CHARGING) {
       Serial.println("Enabled but not charging");
-    } else if(charger.chg_stat() == BQ25186_CC_CHARGING) {
+    } else if(status.chg_stat == BQ25186_CC_CHARGING) {
       Serial.println("Constant current charging");
-    } else if(charger.chg_stat() == BQ25186_CV_CHARGING) {
+    } else if(status.chg_stat == BQ25186_CV_CHARGING) {
       Serial.println("Constant voltage charging");
-    } else if(charger.chg_stat() == BQ25186_CHARGING_DONE_OR_DISABLED) {
+    } else if(status.chg_stat == BQ25186_CHARGING_DONE_OR_DISABLED) {
       Serial.println("Done or disabled");
     } else {
       Serial.print("unknown");
     }
     //Battery voltage
     Serial.print("\r\nBattery\r\nRegulated voltage:");
-    Serial.print(charger.get_vbatreg());
-    Serial.print("v\t");
+    Serial.print(config.vbatreg_mv);
+    Serial.print("mV\t");
     //Charging current
     Serial.print("Charge current:");
-    Serial.print(charger.get_ichg());
+    Serial.print(config.ichg);
     Serial.print("mA\t");
     //Termination current
     Serial.print("Termination charge current:");
-    if(charger.get_iterm() == BQ25186_ITERM_20_PERCENT) {
-      Serial.print("20%");
-    } else if(charger.get_iterm() == BQ25186_ITERM_10_PERCENT) {
-      Serial.print("10%");
-    } else if(charger.get_iterm() == BQ25186_ITERM_5_PERCENT) {
-      Serial.print("5%");
-    } else if(charger.get_iterm() == BQ25186_ITERM_DISABLE) {
-      Serial.print("disabled");
-    } else {
-      Serial.print("unknown");
-    }
+    Serial.print(bq25186::to_text(bq25186_units::iterm, config.iterm));
     Serial.print("\t");
     //Fast charge mode
     Serial.print("Fast charge mode:");
-    printEnabledDisabledLn(charger.get_en_fc_mode());
+    printEnabledDisabledLn(config.en_fc_mode == BQ25186_FLASH_CHG_ENABLED);
     //Discharge current limit
     Serial.print("\r\nProtection\r\nDischarge over current protection limit:");
-    if(charger.get_ibat_ocp() == BQ25186_IBAT_OCP_500MA) {
-      Serial.print(500);
-    } else if(charger.get_ibat_ocp() == BQ25186_IBAT_OCP_1000MA) {
-      Serial.print(1000);
-    } else if(charger.get_ibat_ocp() == BQ25186_IBAT_OCP_1500MA) {
-      Serial.print(1500);
-    } else if(charger.get_ibat_ocp() == BQ25186_IBAT_OCP_3000MA) {
-      Serial.print(3000);
-    } else {
-      Serial.print("unknown ");
-    }
+    Serial.print(bq25186::to_units(bq25186_units::ibat_ocp, config.ibat_ocp));
     Serial.print("mA\t");
     //Battery undervoltage lockout threshold
     Serial.print("Battery undervoltage lockout threshold:");
-    Serial.print(charger.get_buvlo());
-    Serial.println("v\t");
+    Serial.print(config.buvlo_mv);
+    Serial.println("mV\t");
     //Button actions
     Serial.print("\r\nButton\r\nPush:");
-    printEnabledDisabled(charger.get_en_push() == BQ25186_PUSH_ENABLED);
+    printEnabledDisabled(config.en_push == BQ25186_PUSH_ENABLED);
     Serial.print("\tLong press time:");
-    if(charger.get_long_press_time() == BQ25186_MR_LPRESS_5S) {
-      Serial.print(5);
-    } else if(charger.get_long_press_time() == BQ25186_MR_LPRESS_10S) {
-      Serial.print(10);
-    } else if(charger.get_long_press_time() == BQ25186_MR_LPRESS_15S) {
-      Serial.print(15);
-    } else if(charger.get_long_press_time() == BQ25186_MR_LPRESS_20S) {
-      Serial.print(20);
-    } else {
-      Serial.print("unknown ");
-    }
-    Serial.print("s\t");
+    Serial.print(bq25186::to_text(bq25186_units::mr_lpress, config.mr_lpress));
+    Serial.print("\t");
     Serial.print("Long press action:");
-    if(charger.get_long_press_action() == BQ25186_PB_LPRESS_ACTION_NOTHING) {
+    if(config.lpress_action == BQ25186_PB_LPRESS_ACTION_NOTHING) {
       Serial.print("nothing");
-    } else if(charger.get_long_press_action() == BQ25186_PB_LPRESS_ACTION_RESET) {
+    } else if(config.lpress_action == BQ25186_PB_LPRESS_ACTION_RESET) {
       Serial.print("reset");
-    } else if(charger.get_long_press_action() == BQ25186_PB_LPRESS_ACTION_SHIP) {
+    } else if(config.lpress_action == BQ25186_PB_LPRESS_ACTION_SHIP) {
       Serial.print("ship mode");
-    } else if(charger.get_long_press_action() == BQ25186_PB_LPRESS_ACTION_SHUTDOWN) {
+    } else if(config.lpress_action == BQ25186_PB_LPRESS_ACTION_SHUTDOWN) {
       Serial.print("shutdown mode");
     } else {
       Serial.print("unknown");
@@ -139,42 +109,24 @@ void loop() {
     Serial.println();
     //System voltage regulation
     Serial.print("\r\nSystem\r\nRegulated voltage:");
-    if(charger.get_sys_regulation_voltage() == BQ25186_SYS_REG_CTRL_BATTERY_TRACK) {
-      Serial.print("track battery");
-    } else if(charger.get_sys_regulation_voltage() == BQ25186_SYS_REG_CTRL_4_4V) {
-      Serial.print("4.4V");
-    } else if(charger.get_sys_regulation_voltage() == BQ25186_SYS_REG_CTRL_4_5V) {
-      Serial.print("4.5V");
-    } else if(charger.get_sys_regulation_voltage() == BQ25186_SYS_REG_CTRL_4_6V) {
-      Serial.print("4.6V");
-    } else if(charger.get_sys_regulation_voltage() == BQ25186_SYS_REG_CTRL_4_7V) {
-      Serial.print("4.7V");
-    } else if(charger.get_sys_regulation_voltage() == BQ25186_SYS_REG_CTRL_4_8V) {
-      Serial.print("4.8V");
-    } else if(charger.get_sys_regulation_voltage() == BQ25186_SYS_REG_CTRL_4_9V) {
-      Serial.print("4.9V");
-    } else if(charger.get_sys_regulation_voltage() == BQ25186_SYS_REG_CTRL_PASS_THROUGH) {
-      Serial.print("pass through");
-    } else {
-      Serial.print("unknown");
-    }
+    Serial.print(bq25186::to_text(bq25186_units::sys_regulation_voltage, config.sys_regulation_voltage));
     Serial.print("\t");
     //System mode
     Serial.print("Power mode:");
-    if(charger.get_sys_mode() == BQ25186_SYS_MODE_VIN_OR_VBAT) {
+    if(config.sys_mode == BQ25186_SYS_MODE_VIN_OR_VBAT) {
       Serial.print("Charger input or battery\t");
-    } else if(charger.get_sys_mode() == BQ25186_SYS_MODE_VBAT_ONLY) {
+    } else if(config.sys_mode == BQ25186_SYS_MODE_VBAT_ONLY) {
       Serial.print("Battery only\t");
-    } else if(charger.get_sys_mode() == BQ25186_SYS_MODE_FLOAT) {
+    } else if(config.sys_mode == BQ25186_SYS_MODE_FLOAT) {
       Serial.print("disconnected and floating\t");
-    } else if(charger.get_sys_mode() == BQ25186_SYS_MODE_PULLDOWN) {
+    } else if(config.sys_mode == BQ25186_SYS_MODE_PULLDOWN) {
       Serial.print("disconnected and pulled down\t");
     } else {
       Serial.print("unknown");
     }
     //I2C watchdog
     Serial.print("I2C system startup watchdog:");
-    printEnabledDisabledLn(charger.get_i2c_watchdog_mode() == BQ25186_SYS_WATCHDOG_15S_ENABLE);
+    printEnabledDisabledLn(config.i2c_watchdog_mode == BQ25186_SYS_WATCHDOG_15S_ENABLE);
   }
 }
 void printTrueFalse(bool value) {
@@ -25,25 +25,15 @@ void setup() {
   Wire.begin();             //Start I²C
   if(charger.begin()) {     //Start the charger
     Serial.println("Read charger configuration OK");
-    if(charger.set_ichg(200)) { //Set to 200mA
-      Serial.println("Set maximum charging current");
+    charger.begin_config();     //Stage the following settings and write them together with commit()
+    charger.set_ichg(200);      //Set to 200mA
+    charger.set_vbatreg_mv(4200); //Set to 4.2V
+    charger.set_iterm(BQ25186_ITERM_10_PERCENT);  //Set termination current to 10% (default) other reasonable options are BQ25186_ITERM_5_PERCENT BQ25186_ITERM_20_PERCENT
+    charger.set_buvlo_mv(3000); //Battery protection, valid voltages 2.0/2.2/2.4/2.6/2.8/3.0V, others are rounded to the nearest
+    if(charger.commit()) {      //Write all the changes in as few I²C transactions as possible
+      Serial.println("Set charging current, battery regulation voltage, termination current and undervoltage lockout");
     } else {
-      Serial.println("Unable to set maximum charging current");
-    }
-    if(charger.set_vbatreg(4.2)) {  //Set to 4.2V
-      Serial.println("Set battery regulation voltage");
-    } else {
-      Serial.println("Unable to set battery regulation voltage");
-    }
-    if(charger.set_iterm(BQ25186_ITERM_10_PERCENT)) { //Set termination current to 10% (default) other reasonable options are BQ25186_ITERM_5_PERCENT BQ25186_ITERM_20_PERCENT
-      Serial.println("Set battery charge termination current");
-    } else {
-      Serial.println("Unable to set battery charge termination current");
-    }
-    if(charger.set_buvlo(3.0)) {  //Battery protection, valid voltages 2.0/2.2/2.4/2.6/2.8/3.0
-      Serial.println("Set battery undervoltage lockout");
-    } else {
-      Serial.println("Unable to set battery undervoltage lockout");
+      Serial.println("Unable to set charging values");
     }
   } else {
     Serial.println("Unable to read charger registers, is it connected?");
@@ -56,37 +46,30 @@ void loop() {
     Serial.print("Charging state:");
     if(charger.chg_stat() == BQ25186_ENABLED_BUT_NOT_CHARGING) {
       Serial.print("enabled but not charging, battery undervoltage lockout ");
-      Serial.print(charger.get_buvlo());
-      Serial.println('V');
+      Serial.print(charger.get_buvlo_mv());
+      Serial.println("mV");
     } else if(charger.chg_stat() == BQ25186_CC_CHARGING) {
       Serial.print("constant current:");
       Serial.print(charger.get_ichg());
       Serial.println("mA");
     } else if(charger.chg_stat() == BQ25186_CV_CHARGING) {
       Serial.print("constant voltage:");
-      Serial.print(charger.get_vbatreg());
-      Serial.print("v, termination limit: ");
-      if(charger.get_iterm() == BQ25186_ITERM_5_PERCENT) {
-        Serial.print(charger.get_ichg() * 0.05);
-        Serial.println("mA");
-      } else if(charger.get_iterm() == BQ25186_ITERM_10_PERCENT) {
-        Serial.print(charger.get_ichg() * 0.1);
-        Serial.println("mA");
-      } else if(charger.get_iterm() == BQ25186_ITERM_20_PERCENT) {
-        Serial.print(charger.get_ichg() * 0.2);
+      Serial.print(charger.get_vbatreg_mv());
+      Serial.print("mV, termination limit: ");
+      uint8_t itermPercent = charger.get_iterm_percent();  //Termination current is a percentage of the charge current
+      if(itermPercent > 0) {
+        Serial.print(charger.get_ichg() * itermPercent / 100);
         Serial.println("mA");
-      } else if(charger.get_iterm() == BQ25186_ITERM_DISABLE) {
-        Serial.println("disabled");
       } else {
-        Serial.println("unknown");
+        Serial.println("disabled");
       }
     } else if(charger.chg_stat() == BQ25186_CHARGING_DONE_OR_DISABLED) {
       if(charger.vin_pgood_stat() == BQ25186_POWER_GOOD) {
         Serial.println("done");
       } else {
         Serial.print("disabled, battery undervoltage lockout ");
-        Serial.print(charger.get_buvlo());
-        Serial.println('V');
+        Serial.print(charger.get_buvlo_mv());
+        Serial.println("mV");
       }
     } else {
       Serial.println("unknown");
@@ -10,32 +10,231 @@
 #ifndef bq25186_cpp
 #define bq25186_cpp
 #include "bq25186.h"
+#if !defined(ARDUINO)
+#include <stdio.h>
+#endif
+
+#if defined BQ25186_THREAD_SAFE
+	#define BQ25186_LOCK() bq25186_lock lock(bus_mutex_); call_timer_ callTimer(this)	//Hold the mutex and time the call until the end of the enclosing block
+#else
+	#define BQ25186_LOCK() call_timer_ callTimer(this)
+#endif
+static const uint8_t bq25186_config_bits_[] = {		//Bits that hold configuration and read back as written, the reset and ship mode bits of 0x09 act and clear themselves
+	0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x1f, 0xff, 0xff, 0xf0
+};
+
+#if !defined(ARDUINO)
+	#define PROGMEM
+	#define pgm_read_word(address) (*(const uint16_t *)(address))
+#endif
+
+//Physical units and display strings of the enumerated fields, indexed by the field's code, 0 where a setting isn't a fixed value
+
+static const uint16_t bq25186_ilim_units_[] PROGMEM = {50, 100, 200, 300, 400, 500, 665, 1050};
+static const char bq25186_ilim_text_[][7] PROGMEM = {"50mA", "100mA", "200mA", "300mA", "400mA", "500mA", "665mA", "1050mA"};
+static const uint16_t bq25186_ibat_ocp_units_[] PROGMEM = {500, 1000, 1500, 3000};
+static const char bq25186_ibat_ocp_text_[][7] PROGMEM = {"500mA", "1000mA", "1500mA", "3000mA"};
+static const uint16_t bq25186_buvlo_units_[] PROGMEM = {3000, 3000, 3000, 2800, 2600, 2400, 2200, 2000};
+static const char bq25186_buvlo_text_[][5] PROGMEM = {"3.0V", "3.0V", "3.0V", "2.8V", "2.6V", "2.4V", "2.2V", "2.0V"};
+static const uint16_t bq25186_sys_regulation_voltage_units_[] PROGMEM = {0, 4400, 4500, 4600, 4700, 4800, 4900, 0};
+static const char bq25186_sys_regulation_voltage_text_[][14] PROGMEM = {"track battery", "4.4V", "4.5V", "4.6V", "4.7V", "4.8V", "4.9V", "pass through"};
+static const uint16_t bq25186_vindpm_units_[] PROGMEM = {0, 4500, 4700, 0};
+static const char bq25186_vindpm_text_[][14] PROGMEM = {"battery+300mV", "4.5V", "4.7V", "disabled"};
+static const uint16_t bq25186_iterm_units_[] PROGMEM = {0, 5, 10, 20};
+static const char bq25186_iterm_text_[][9] PROGMEM = {"disabled", "5%", "10%", "20%"};
+static const uint16_t bq25186_autowake_units_[] PROGMEM = {500, 1000, 2000, 4000};
+static const char bq25186_autowake_text_[][5] PROGMEM = {"0.5s", "1s", "2s", "4s"};
+static const uint16_t bq25186_mr_lpress_units_[] PROGMEM = {5, 10, 15, 20};
+static const char bq25186_mr_lpress_text_[][4] PROGMEM = {"5s", "10s", "15s", "20s"};
+static const char bq25186_unknown_text_[] PROGMEM = "unknown";
+
+#define BQ25186_FIELD_UNITS(field) {bq25186_fields::field::mask, bq25186_fields::field::shift, sizeof(bq25186_##field##_units_) / sizeof(bq25186_##field##_units_[0]), \
+	bq25186_##field##_units_, bq25186_##field##_text_[0], sizeof(bq25186_##field##_text_[0])}
+
+namespace bq25186_units {
+	const bq25186_field_units ilim = BQ25186_FIELD_UNITS(ilim);
+	const bq25186_field_units ibat_ocp = BQ25186_FIELD_UNITS(ibat_ocp);
+	const bq25186_field_units buvlo = BQ25186_FIELD_UNITS(buvlo);
+	const bq25186_field_units sys_regulation_voltage = BQ25186_FIELD_UNITS(sys_regulation_voltage);
+	const bq25186_field_units vindpm = BQ25186_FIELD_UNITS(vindpm);
+	const bq25186_field_units iterm = BQ25186_FIELD_UNITS(iterm);
+	const bq25186_field_units autowake = BQ25186_FIELD_UNITS(autowake);
+	const bq25186_field_units mr_lpress = BQ25186_FIELD_UNITS(mr_lpress);
+}
+
+#if BQ25186_LOG_LEVEL > BQ25186_LOG_NONE
+	#define BQ25186_LOG(level, event, reg, mask, oldValue, newValue, error) do { if(level <= BQ25186_LOG_LEVEL) { log_event_(event, reg, mask, oldValue, newValue, error); } } while(0)
+#else
+	#define BQ25186_LOG(level, event, reg, mask, oldValue, newValue, error) do {} while(0)	//Compiles to nothing
+#endif
+
+//Check the register map, every field of a register is listed so any overlap from a copy-paste mistake fails to compile
+
+namespace bq25186_fields {
+static_assert(bq25186_register_layout<ts_open_stat, chg_stat, ilim_active_stat, vdppm_active_stat, vindpm_active_stat, thermreg_active_stat, vin_pgood_stat>::valid, "Register 0x00 fields overlap");
+static_assert(bq25186_register_layout<vin_ovp_stat, buvlo_stat, ts_stat, safety_tmr_fault_flag, wake1_flag, wake2_flag>::valid, "Register 0x01 fields overlap");
+static_assert(bq25186_register_layout<ts_fault, ilim_active_flag, vdppm_active_flag, vindpm_active_flag, thermreg_active_flag, vin_ovp_fault_flag, buvlo_fault_flag, bat_ocp_fault>::valid, "Register 0x02 fields overlap");
+static_assert(bq25186_register_layout<pg_pin_mode, vbatreg>::valid, "Register 0x03 fields overlap");
+static_assert(bq25186_register_layout<chg_dis, ichg>::valid, "Register 0x04 fields overlap");
+static_assert(bq25186_register_layout<en_fc_mode, iprechg, iterm, vindpm, therm_reg>::valid, "Register 0x05 fields overlap");
+static_assert(bq25186_register_layout<ibat_ocp, buvlo, chg_status_int_mask, ilim_int_mask, vindpm_int_mask>::valid, "Register 0x06 fields overlap");
+static_assert(bq25186_register_layout<ts_en, vlowv_sel, vrch, timer_2x_en, safety_timer, watchdog_sel>::valid && bq25186_register_layout<ts_en, vlowv_sel, vrch, timer_2x_en, safety_timer, watchdog_sel>::mask == 0xff, "Register 0x07 fields overlap");
+static_assert(bq25186_register_layout<mr_lpress, mr_reset_vin, autowake, ilim>::valid, "Register 0x08 fields overlap");
+static_assert(bq25186_register_layout<reg_rst, reset_ship, lpress_action, wake1_tmr, wake2_tmr, en_push>::valid, "Register 0x09 fields overlap");
+static_assert(bq25186_register_layout<sys_regulation_voltage, pg_pin_state, sys_mode, i2c_watchdog_mode>::valid, "Register 0x0a fields overlap");
+static_assert(bq25186_register_layout<ts_open_stat, chg_stat, ilim_active_stat, vdppm_active_stat, vindpm_active_stat, thermreg_active_stat, vin_pgood_stat>::mask == 0xff, "Register 0x00 is not fully described");
+static_assert(bq25186_register_layout<ts_fault, ilim_active_flag, vdppm_active_flag, vindpm_active_flag, thermreg_active_flag, vin_ovp_fault_flag, buvlo_fault_flag, bat_ocp_fault>::mask == 0xff, "Register 0x02 is not fully described");
+static_assert(bq25186_register_layout<mr_lpress, mr_reset_vin, autowake, ilim>::mask == 0xff, "Register 0x08 is not fully described");
+static_assert(ilim::valid(BQ25186_ILIM_1050_MA) && autowake::valid(BQ25186_AUTOWAKE_4_S), "ILIM and AUTOWAKE values are in the wrong field");
+}
 
+bq25186 *bq25186::interrupt_instance_ = nullptr;
 
 bq25186::bq25186()	//Constructor function
 {
+	#if defined BQ25186_THREAD_SAFE
+		#if defined(ESP32)
+		own_mutex_ = xSemaphoreCreateRecursiveMutex();
+		bus_mutex_ = own_mutex_;
+		#else
+		bus_mutex_ = &own_mutex_;
+		#endif
+	#endif
 }
 
 bq25186::~bq25186()	//Destructor function
 {
+	#if defined(ARDUINO)
+	disable_interrupt();
+	#endif
+	#if defined BQ25186_THREAD_SAFE
+	stop_worker();
+		#if defined(ESP32)
+		if(own_mutex_ != nullptr) {
+			vSemaphoreDelete(own_mutex_);
+		}
+		#endif
+	#endif
+}
+#if defined BQ25186_THREAD_SAFE
+bq25186_lock::bq25186_lock(bq25186_mutex_t mutex) : mutex_(mutex) {
+	#if defined(ESP32)
+	xSemaphoreTakeRecursive(mutex_, portMAX_DELAY);
+	#else
+	mutex_->lock();
+	#endif
+}
+bq25186_lock::~bq25186_lock() {
+	#if defined(ESP32)
+	xSemaphoreGiveRecursive(mutex_);
+	#else
+	mutex_->unlock();
+	#endif
+}
+void bq25186::set_bus_mutex(bq25186_mutex_t mutex) {
+	#if defined(ESP32)
+	if(own_mutex_ != nullptr && mutex != own_mutex_) {	//The library's own mutex is no longer needed
+		vSemaphoreDelete(own_mutex_);
+		own_mutex_ = nullptr;
+	}
+	#endif
+	bus_mutex_ = mutex;
+}
+bq25186_mutex_t bq25186::get_bus_mutex() {
+	return bus_mutex_;
+}
+bool bq25186::start_worker(uint32_t stackSize, uint8_t priority) {
+	if(worker_running_) {
+		return false;
+	}
+	worker_running_ = true;
+	#if defined(ESP32)
+	worker_stopped_ = xSemaphoreCreateBinary();
+	if(worker_stopped_ == nullptr) {
+		worker_running_ = false;
+		return false;
+	}
+	if(xTaskCreate(worker_task_, "bq25186", stackSize, this, priority, &worker_handle_) != pdPASS) {
+		vSemaphoreDelete(worker_stopped_);
+		worker_stopped_ = nullptr;
+		worker_running_ = false;
+		return false;
+	}
+	#else
+	(void)stackSize;		//The host scheduler decides these
+	(void)priority;
+	worker_thread_ = std::thread([this]() {
+		while(worker_running_) {
+			if(update() == false) {						//Nothing more queued, sleep until there is
+				std::unique_lock<std::mutex> wakeLock(worker_wake_mutex_);
+				worker_wake_.wait(wakeLock, [this]() { return worker_work_queued_ || worker_running_ == false; });
+				worker_work_queued_ = false;
+			}
+		}
+	});
+	#endif
+	return true;
+}
+void bq25186::stop_worker() {
+	if(worker_running_ == false) {
+		return;
+	}
+	worker_running_ = false;
+	#if defined(ESP32)
+	xTaskNotifyGive(worker_handle_);					//The task deletes itself once woken
+	xSemaphoreTake(worker_stopped_, portMAX_DELAY);		//Wait until it no longer uses this instance
+	vSemaphoreDelete(worker_stopped_);
+	worker_stopped_ = nullptr;
+	#else
+	wake_worker_();
+	worker_thread_.join();
+	#endif
+}
+#if defined(ESP32)
+void bq25186::worker_task_(void *parameter) {
+	bq25186 *charger = static_cast<bq25186 *>(parameter);
+	while(charger->worker_running_) {
+		if(charger->update() == false) {				//Nothing more queued, sleep until there is
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		}
+	}
+	SemaphoreHandle_t stopped = charger->worker_stopped_;
+	charger->worker_handle_ = nullptr;
+	xSemaphoreGive(stopped);							//The instance may be destroyed from here on
+	vTaskDelete(nullptr);
+}
+#endif
+void bq25186::wake_worker_() {
+	#if defined(ESP32)
+	if(worker_handle_ != nullptr) {
+		xTaskNotifyGive(worker_handle_);
+	}
+	#else
+	{
+		std::lock_guard<std::mutex> wakeLock(worker_wake_mutex_);
+		worker_work_queued_ = true;
+	}
+	worker_wake_.notify_one();
+	#endif
 }
+#endif
 
+#if defined(ARDUINO)
 bool bq25186::begin(TwoWire &wirePort) {
-	i2cPort_ = &wirePort;			//Set the wire instance used for the charger
+	wire_bus_.set_wire(wirePort);	//Set the wire instance used for the charger
+	return begin(wire_bus_);
+}
+#endif
+bool bq25186::begin(bq25186_bus &bus) {
+	BQ25186_LOCK();
+	bus_ = &bus;					//Set the bus used for the charger
+	registers_known_ = 0;			//Nothing to compare the first read with
+	reset_count_ = 0;
 	bq25186_communicating_ok_ = read_registers_();
 	if(bq25186_communicating_ok_) {	//Read all registers at startup
-		#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-		if(debug_uart_ != nullptr) {
-			debug_uart_->println(F("BQ25186 library started"));
-		}
-		#endif
-	} else {
-		#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-		if(debug_uart_ != nullptr) {
-			debug_uart_->println(F("Unable to communicate with BQ25186"));
-		}
-		#endif
+		config_refresh_timer_ = millis();
 	}
+	BQ25186_LOG(BQ25186_LOG_INFO, BQ25186_EVENT_BEGIN, 0x00, 0, 0, bq25186_communicating_ok_, last_bus_error_);
 	return bq25186_communicating_ok_;
 }
 #if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
@@ -68,6 +267,8 @@ void bq25186::printBinaryLn(uint8_t value) {
 	debug_uart_->println();
 }
 void bq25186::print_registers() {
+	BQ25186_LOCK();
+	invalidate_cache();	//Always show what is actually in the device
 	auto_refresh_all_registers_();
 	if(debug_uart_ != nullptr) {
 		for(uint8_t index = 0; index < bq25186_number_of_registers_; index++) {	//Iterate all the registers and print them
@@ -82,139 +283,1078 @@ void bq25186::print_registers() {
 }
 #endif
 bool bq25186::auto_refresh_all_registers_() {
-	if(millis() - register_refresh_timer_ > register_refresh_rate_limit_) {
-		register_refresh_timer_ = millis();
-		#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-		if(debug_uart_ != nullptr) {
-			debug_uart_->print(F("Refreshing BQ25186 register values "));
+	return auto_refresh_registers_(0x00, bq25186_number_of_registers_);
+}
+bool bq25186::get_registers(uint8_t start, uint8_t length, uint8_t *values) {
+	BQ25186_LOCK();
+	if(start >= bq25186_number_of_registers_ || length > bq25186_number_of_registers_ - start) {
+		return false;
+	}
+	if(auto_refresh_registers_(start, length) == false) {	//At most one burst read
+		return false;
+	}
+	memcpy(values, &registers[start], length);
+	return true;
+}
+uint16_t bq25186::to_units(const bq25186_field_units &field, uint8_t value) {
+	if(value == BQ25186_I2C_ERROR) {
+		return 0;
+	}
+	return pgm_read_word(&field.units[(value & field.mask) >> field.shift]);
+}
+uint8_t bq25186::from_units(const bq25186_field_units &field, uint16_t units) {
+	uint8_t nearest = 0;
+	uint16_t nearestDistance = 0xffff;
+	for(uint8_t code = 0; code < field.codes; code++) {				//The first code closest to the units
+		uint16_t codeUnits = pgm_read_word(&field.units[code]);
+		if(codeUnits == 0) {
+			continue;
+		}
+		uint16_t distance = codeUnits > units ? codeUnits - units : units - codeUnits;
+		if(distance < nearestDistance) {
+			nearest = code;
+			nearestDistance = distance;
 		}
-		#endif
-		bq25186_communicating_ok_ = read_registers_();
 	}
-	return bq25186_communicating_ok_;
+	return (nearest << field.shift) & field.mask;
 }
-bool bq25186::read_registers_(uint8_t start, uint8_t length, bool stop) {
-	i2cPort_->beginTransmission(bq25186_i2c_address_);			//Start I2C transmission
-	i2cPort_->write(start);										//Send the register to begin reading from
-	if(i2cPort_->endTransmission() == 0)						//Check that it was sent
-	{
-		uint8_t bytesReceived = i2cPort_->requestFrom(bq25186_i2c_address_, bq25186_number_of_registers_, stop);	//Request the registers and optionally send a 'stop'
-		if(bytesReceived == length) {
-			while(i2cPort_->available() && bytesReceived > 0) {
-				registers[length-bytesReceived] = i2cPort_->read();		//Read the current byte
-				bytesReceived--;
-			}
-			if(bytesReceived == 0) {
-				#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-				if(debug_uart_ != nullptr) {
-					debug_uart_->println(F("Succesfully read BQ25186 registers"));
-				}
-				#endif
-				return true;
-			} else {
-				#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-				if(debug_uart_ != nullptr) {
-					debug_uart_->println(F("Incomplete read of BQ25186 registers"));
-				}
-				#endif
-				return false;
+const bq25186_text *bq25186::to_text(const bq25186_field_units &field, uint8_t value) {
+	if(value == BQ25186_I2C_ERROR) {
+		return reinterpret_cast<const bq25186_text *>(bq25186_unknown_text_);
+	}
+	return reinterpret_cast<const bq25186_text *>(field.text + ((value & field.mask) >> field.shift) * field.text_width);
+}
+bool bq25186::read_status(bq25186_status &status) {
+	BQ25186_LOCK();
+	if(auto_refresh_registers_(0x00, bq25186_number_of_status_registers_) == false) {	//At most one burst read
+		return false;
+	}
+	status.ts_open = cached_field_<bq25186_fields::ts_open_stat>();
+	status.chg_stat = cached_field_<bq25186_fields::chg_stat>();
+	status.ilim_active = cached_field_<bq25186_fields::ilim_active_stat>();
+	status.vdppm_active = cached_field_<bq25186_fields::vdppm_active_stat>();
+	status.vindpm_active = cached_field_<bq25186_fields::vindpm_active_stat>();
+	status.thermreg_active = cached_field_<bq25186_fields::thermreg_active_stat>();
+	status.vin_pgood = cached_field_<bq25186_fields::vin_pgood_stat>();
+	status.vin_ovp = cached_field_<bq25186_fields::vin_ovp_stat>();
+	status.buvlo = cached_field_<bq25186_fields::buvlo_stat>();
+	status.ts_stat = cached_field_<bq25186_fields::ts_stat>();
+	status.safety_tmr_fault = cached_field_<bq25186_fields::safety_tmr_fault_flag>();
+	status.wake1 = cached_field_<bq25186_fields::wake1_flag>();
+	status.wake2 = cached_field_<bq25186_fields::wake2_flag>();
+	status.ts_fault = cached_field_<bq25186_fields::ts_fault>();
+	status.ilim_active_flag = cached_field_<bq25186_fields::ilim_active_flag>();
+	status.vdppm_active_flag = cached_field_<bq25186_fields::vdppm_active_flag>();
+	status.vindpm_active_flag = cached_field_<bq25186_fields::vindpm_active_flag>();
+	status.thermreg_active_flag = cached_field_<bq25186_fields::thermreg_active_flag>();
+	status.vin_ovp_fault = cached_field_<bq25186_fields::vin_ovp_fault_flag>();
+	status.buvlo_fault = cached_field_<bq25186_fields::buvlo_fault_flag>();
+	status.bat_ocp_fault = cached_field_<bq25186_fields::bat_ocp_fault>();
+	return true;
+}
+bool bq25186::read_config(bq25186_config &config) {
+	BQ25186_LOCK();
+	if(auto_refresh_registers_(bq25186_number_of_status_registers_, bq25186_number_of_registers_ - bq25186_number_of_status_registers_) == false) {	//At most one burst read
+		return false;
+	}
+	config.pg_pin_mode = cached_field_<bq25186_fields::pg_pin_mode>();
+	config.vbatreg_mv = decode_vbatreg_(cached_field_<bq25186_fields::vbatreg>());
+	#if defined BQ25186_INCLUDE_FLOAT_API
+	config.vbatreg = config.vbatreg_mv / 1000.0;
+	#endif
+	config.chg_dis = cached_field_<bq25186_fields::chg_dis>();
+	config.ichg = decode_ichg_(cached_field_<bq25186_fields::ichg>());
+	config.en_fc_mode = cached_field_<bq25186_fields::en_fc_mode>();
+	config.iprechg = cached_field_<bq25186_fields::iprechg>();
+	config.iterm = cached_field_<bq25186_fields::iterm>();
+	config.vindpm = cached_field_<bq25186_fields::vindpm>();
+	config.therm_reg = cached_field_<bq25186_fields::therm_reg>();
+	config.ibat_ocp = cached_field_<bq25186_fields::ibat_ocp>();
+	config.buvlo_mv = to_units(bq25186_units::buvlo, cached_field_<bq25186_fields::buvlo>());
+	#if defined BQ25186_INCLUDE_FLOAT_API
+	config.buvlo = config.buvlo_mv / 1000.0;
+	#endif
+	config.chg_status_int_mask = cached_field_<bq25186_fields::chg_status_int_mask>();
+	config.ilim_int_mask = cached_field_<bq25186_fields::ilim_int_mask>();
+	config.vindpm_int_mask = cached_field_<bq25186_fields::vindpm_int_mask>();
+	config.mr_lpress = cached_field_<bq25186_fields::mr_lpress>();
+	config.mr_reset_vin = cached_field_<bq25186_fields::mr_reset_vin>();
+	config.autowake = cached_field_<bq25186_fields::autowake>();
+	config.ilim = cached_field_<bq25186_fields::ilim>();
+	config.lpress_action = cached_field_<bq25186_fields::lpress_action>();
+	config.wake1_tmr = cached_field_<bq25186_fields::wake1_tmr>();
+	config.wake2_tmr = cached_field_<bq25186_fields::wake2_tmr>();
+	config.en_push = cached_field_<bq25186_fields::en_push>();
+	config.sys_regulation_voltage = cached_field_<bq25186_fields::sys_regulation_voltage>();
+	config.pg_pin_state = cached_field_<bq25186_fields::pg_pin_state>();
+	config.sys_mode = cached_field_<bq25186_fields::sys_mode>();
+	config.i2c_watchdog_mode = cached_field_<bq25186_fields::i2c_watchdog_mode>();
+	return true;
+}
+bool bq25186::get_config_image(bq25186_config_image &image) {
+	BQ25186_LOCK();
+	if(auto_refresh_registers_(bq25186_number_of_status_registers_, bq25186_number_of_registers_ - bq25186_number_of_status_registers_) == false) {
+		return false;
+	}
+	image.version = BQ25186_CONFIG_IMAGE_VERSION;
+	for(uint8_t index = bq25186_number_of_status_registers_; index < bq25186_number_of_registers_; index++) {
+		image.registers[index - bq25186_number_of_status_registers_] = registers[index] & bq25186_config_bits_[index];	//Never save a reset or ship mode request
+	}
+	image.crc = config_image_crc_(image);
+	return true;
+}
+/*
+The image is compared with the cached registers, which begin() has just read, so a warm boot where nothing has changed needs no writes. Every register
+from the first that differs to the last is written in one burst, the unchanged ones in between with the values just read, as one longer transaction
+costs less than several short ones. Inside begin_config() the changes are only staged until commit().
+*/
+bool bq25186::apply_config_image(const bq25186_config_image &image) {
+	BQ25186_LOCK();
+	if(config_image_valid(image) == false) {
+		return false;
+	}
+	if(auto_refresh_registers_(bq25186_number_of_status_registers_, bq25186_number_of_registers_ - bq25186_number_of_status_registers_) == false) {
+		return false;
+	}
+	uint8_t first = bq25186_number_of_registers_;
+	uint8_t last = 0;
+	for(uint8_t index = bq25186_number_of_status_registers_; index < bq25186_number_of_registers_; index++) {
+		uint8_t value = image.registers[index - bq25186_number_of_status_registers_];
+		uint8_t newValue = (registers[index] & ~bq25186_config_bits_[index]) | (value & bq25186_config_bits_[index]);
+		if(newValue != registers[index]) {
+			BQ25186_LOG(BQ25186_LOG_TRACE, BQ25186_EVENT_STAGE, index, bq25186_config_bits_[index], registers[index], newValue, BQ25186_BUS_OK);
+			registers[index] = newValue;
+			if(first == bq25186_number_of_registers_) {
+				first = index;
 			}
+			last = index;
+		}
+	}
+	if(first == bq25186_number_of_registers_) {
+		return true;									//Already matches, nothing to write
+	}
+	if(first <= 0x09 && last >= 0x09) {
+		registers[0x09] &= bq25186_config_bits_[0x09];	//Part of the burst, so make sure it requests no reset
+	}
+	registers_dirty_ |= ((1U << (last - first + 1)) - 1) << first;
+	if(config_transaction_) {
+		return true;
+	}
+	return commit();
+}
+uint8_t bq25186::config_image_crc_(const bq25186_config_image &image) {
+	uint8_t crc = crc8_(0x00, image.version);			//Each field in turn, not the bytes of the struct
+	for(uint8_t index = 0; index < sizeof(image.registers); index++) {
+		crc = crc8_(crc, image.registers[index]);
+	}
+	return crc;
+}
+uint8_t bq25186::crc8_(uint8_t crc, uint8_t value) {
+	crc ^= value;
+	for(uint8_t bit = 0; bit < 8; bit++) {
+		crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+	}
+	return crc;
+}
+bool bq25186::config_image_valid(const bq25186_config_image &image) {
+	return image.version == BQ25186_CONFIG_IMAGE_VERSION && image.crc == config_image_crc_(image);
+}
+#if !defined(ARDUINO)
+bool bq25186::save_config_image(const char *path, const bq25186_config_image &image) {
+	FILE *file = fopen(path, "wb");
+	if(file == nullptr) {
+		return false;
+	}
+	bool written = fwrite(&image, sizeof(image), 1, file) == 1;
+	return fclose(file) == 0 && written;
+}
+bool bq25186::load_config_image(const char *path, bq25186_config_image &image) {
+	FILE *file = fopen(path, "rb");
+	if(file == nullptr) {
+		return false;
+	}
+	bool read = fread(&image, sizeof(image), 1, file) == 1;
+	fclose(file);
+	return read && config_image_valid(image);
+}
+#endif
+void bq25186::accumulate_faults_(uint8_t start, uint8_t length) {
+	uint16_t flags = 0;
+	if(start <= 0x01 && start + length > 0x01) {				//Only registers just read, cached flags were already counted
+		flags |= registers[0x01] & BQ25186_I2C_BITMASK_2_0;
+	}
+	if(start <= 0x02 && start + length > 0x02) {
+		flags |= uint16_t(registers[0x02]) << 3;
+	}
+	pending_faults_ |= flags;
+	for(uint8_t latch = 0; latch < fault_latch_count_; latch++) {
+		*fault_latches_[latch] |= flags;
+	}
+	for(uint8_t index = 0; flags != 0; index++, flags >>= 1) {	//Each flag read as set is a new occurrence
+		if((flags & 0x0001) && fault_counts_[index] < 0xffff) {
+			fault_counts_[index]++;
+		}
+	}
+}
+uint16_t bq25186::pending_faults() {
+	BQ25186_LOCK();
+	return pending_faults_;
+}
+uint16_t bq25186::take_faults() {
+	BQ25186_LOCK();
+	uint16_t faults = pending_faults_;
+	pending_faults_ = 0;
+	return faults;
+}
+uint16_t bq25186::get_fault_count(uint16_t flag) {
+	BQ25186_LOCK();
+	for(uint8_t index = 0; index < bq25186_number_of_flags_; index++) {
+		if(flag == (1U << index)) {
+			return fault_counts_[index];
+		}
+	}
+	return 0;
+}
+void bq25186::reset_fault_counts() {
+	BQ25186_LOCK();
+	for(uint8_t index = 0; index < bq25186_number_of_flags_; index++) {
+		fault_counts_[index] = 0;
+	}
+}
+bool bq25186::add_fault_latch(uint16_t &latch) {
+	BQ25186_LOCK();
+	for(uint8_t index = 0; index < fault_latch_count_; index++) {
+		if(fault_latches_[index] == &latch) {
+			return true;							//Already added
+		}
+	}
+	if(fault_latch_count_ == BQ25186_MAX_FAULT_LATCHES) {
+		return false;
+	}
+	fault_latches_[fault_latch_count_++] = &latch;
+	return true;
+}
+void bq25186::remove_fault_latch(uint16_t &latch) {
+	BQ25186_LOCK();
+	uint8_t kept = 0;
+	for(uint8_t index = 0; index < fault_latch_count_; index++) {
+		if(fault_latches_[index] != &latch) {
+			fault_latches_[kept++] = fault_latches_[index];
+		}
+	}
+	fault_latch_count_ = kept;
+}
+uint16_t bq25186::take_fault_latch(uint16_t &latch) {
+	BQ25186_LOCK();									//The latch is written under the lock as flags are read
+	uint16_t faults = latch;
+	latch = 0;
+	return faults;
+}
+void bq25186::set_status_cache_ttl(uint32_t milliseconds) {
+	BQ25186_LOCK();
+	status_cache_ttl_ = milliseconds;
+}
+void bq25186::set_config_cache_ttl(uint32_t milliseconds) {
+	BQ25186_LOCK();
+	config_cache_ttl_ = milliseconds;
+	config_refresh_timer_ = millis();
+}
+void bq25186::invalidate_cache() {
+	BQ25186_LOCK();
+	registers_fresh_ = 0;
+}
+void bq25186::invalidate_status_cache() {
+	BQ25186_LOCK();
+	registers_fresh_ &= ~bq25186_status_registers_mask_;
+}
+bool bq25186::auto_refresh_registers_(uint8_t start, uint8_t length) {
+	if(status_cache_ttl_ > 0 && millis() - status_refresh_timer_ > status_cache_ttl_) {	//Volatile status has expired
+		registers_fresh_ &= ~bq25186_status_registers_mask_;
+	}
+	if(config_cache_ttl_ > 0 && millis() - config_refresh_timer_ > config_cache_ttl_) {	//Optional re-validation of the configuration shadow
+		config_refresh_timer_ = millis();
+		registers_fresh_ &= bq25186_status_registers_mask_ | registers_dirty_;	//Never re-read over changes staged for commit()
+	}
+	uint16_t rangeMask = ((1U << length) - 1) << start;						//The registers this refresh covers
+	#if defined BQ25186_INCLUDE_STATISTICS
+	for(uint8_t index = start; index < start + length; index++) {
+		if(registers_fresh_ & (1U << index)) {
+			stats_.cache_hits[index]++;
 		} else {
-			#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-			if(debug_uart_ != nullptr) {
-				debug_uart_->println(F("Unable to read BQ25186 registers"));
+			stats_.cache_misses[index]++;
+		}
+	}
+	#endif
+	if((registers_fresh_ & rangeMask) != rangeMask) {
+		bq25186_communicating_ok_ = read_registers_(start, length);
+		return bq25186_communicating_ok_;
+	}
+	return true;									//All fresh, whatever happened to other registers
+}
+void bq25186::registers_received_(uint8_t start, const uint8_t *values, uint8_t length) {
+	uint16_t rangeMask = ((1U << length) - 1) << start;
+	bool reset = false;
+	if(reset_sentinel_ >= start && reset_sentinel_ < start + length && (registers_known_ & (1U << reset_sentinel_)) &&
+		(registers_dirty_ & (1U << reset_sentinel_)) == 0) {
+		reset = ((values[reset_sentinel_ - start] ^ registers[reset_sentinel_]) & bq25186_config_bits_[reset_sentinel_]) != 0;	//The shadow follows every write, so any difference is the device
+	}
+	uint8_t previous[bq25186_number_of_registers_];
+	if(subscriber_count_ > 0) {
+		memcpy(previous, &registers[start], length);	//Keep the shadow to compare against, only if anyone is listening
+	}
+	for(uint8_t index = start; index < start + length; index++) {
+		if((registers_dirty_ & (1U << index)) == 0) {		//Changes staged for commit() are kept
+			registers[index] = values[index - start];
+		}
+	}
+	registers_fresh_ |= rangeMask;
+	if(rangeMask & bq25186_status_registers_mask_) {
+		status_refresh_timer_ = millis();
+	}
+	if(start <= 0x02 && start + length > 0x01) {	//Flag registers are cleared by reading, so keep what was seen
+		accumulate_faults_(start, length);
+	}
+	if(subscriber_count_ > 0) {
+		notify_subscribers_(start, previous, length);
+	}
+	uint16_t firstRead = rangeMask & ~registers_known_ & ~registers_dirty_ & ~bq25186_status_registers_mask_;
+	for(uint8_t index = start; firstRead != 0 && index < start + length; index++) {
+		if(firstRead & (1U << index)) {
+			track_config_(index, &values[index - start], 1);	//Eg. the defaults after a reset the library asked for
+		}
+	}
+	registers_known_ |= rangeMask;
+	if(reset) {
+		reset_count_++;
+		reset_restore_pending_ = true;
+	}
+	if(reset_restore_pending_ && reset_sentinel_ != 0 && start <= reset_sentinel_) {
+		reset_restore_try_ = true;						//Written back at the end of the outermost call, never part way through one
+	}
+}
+/*
+A reset returns every configuration register to its default, so rather than read them all to find which differ the whole image is written in one
+burst. The bits of each register that aren't configuration keep the value last read.
+*/
+void bq25186::restore_config_() {
+	reset_restore_try_ = false;
+	uint8_t values[bq25186_number_of_registers_ - bq25186_number_of_status_registers_];
+	for(uint8_t index = bq25186_number_of_status_registers_; index < bq25186_number_of_registers_; index++) {
+		values[index - bq25186_number_of_status_registers_] = (registers[index] & ~bq25186_config_bits_[index]) |
+			(reset_image_.registers[index - bq25186_number_of_status_registers_] & bq25186_config_bits_[index]);
+	}
+	values[0x09 - bq25186_number_of_status_registers_] &= bq25186_config_bits_[0x09];	//Never a reset or ship mode request
+	if(write_registers_(bq25186_number_of_status_registers_, values, sizeof(values))) {
+		memcpy(&registers[bq25186_number_of_status_registers_], values, sizeof(values));
+		registers_fresh_ |= ~bq25186_status_registers_mask_ & ((1U << bq25186_number_of_registers_) - 1);
+		registers_known_ |= ~bq25186_status_registers_mask_ & ((1U << bq25186_number_of_registers_) - 1);
+		reset_restore_pending_ = false;
+		BQ25186_LOG(BQ25186_LOG_INFO, BQ25186_EVENT_RESET, bq25186_number_of_status_registers_, sizeof(values), 0, 0, BQ25186_BUS_OK);
+	} else {
+		BQ25186_LOG(BQ25186_LOG_ERROR, BQ25186_EVENT_RESET, bq25186_number_of_status_registers_, sizeof(values), 0, 0, last_bus_error_);
+	}
+	if(reset_callback_ != nullptr) {
+		reset_callback_(reset_restore_pending_ == false);
+	}
+}
+void bq25186::track_config_(uint8_t start, const uint8_t *values, uint8_t length) {
+	if(reset_sentinel_ == 0) {
+		return;										//Detection is off, set_reset_detection() replaces the whole image
+	}
+	bool changed = false;
+	for(uint8_t index = start; index < start + length; index++) {
+		if(index >= bq25186_number_of_status_registers_ && index < bq25186_number_of_registers_) {
+			uint8_t &imageValue = reset_image_.registers[index - bq25186_number_of_status_registers_];
+			uint8_t newValue = (imageValue & ~bq25186_config_bits_[index]) | (values[index - start] & bq25186_config_bits_[index]);
+			changed = changed || newValue != imageValue;
+			imageValue = newValue;
+		}
+	}
+	if(changed) {
+		reset_image_.crc = config_image_crc_(reset_image_);
+	}
+}
+bool bq25186::restore_due_() {
+	return reset_restore_try_ && reset_restore_pending_ && reset_sentinel_ != 0 && config_transaction_ == false &&
+		async_state_ == BQ25186_ASYNC_IDLE;
+}
+void bq25186::reset_requested_cache_() {
+	invalidate_cache();
+	registers_known_ &= bq25186_status_registers_mask_;	//The configuration is meant to be at its defaults now
+	reset_restore_pending_ = false;
+}
+bool bq25186::set_reset_detection(const bq25186_config_image &image, uint8_t sentinel) {
+	BQ25186_LOCK();
+	if(config_image_valid(image) == false || sentinel < bq25186_number_of_status_registers_ || sentinel >= bq25186_number_of_registers_ ||
+		bq25186_config_bits_[sentinel] == 0) {
+		return false;
+	}
+	reset_image_ = image;
+	reset_sentinel_ = sentinel;
+	reset_restore_pending_ = false;
+	return true;
+}
+void bq25186::disable_reset_detection() {
+	BQ25186_LOCK();
+	reset_sentinel_ = 0;
+	reset_restore_pending_ = false;
+}
+void bq25186::set_reset_callback(void (*callback)(bool)) {
+	BQ25186_LOCK();
+	reset_callback_ = callback;
+}
+uint16_t bq25186::get_reset_count() {
+	BQ25186_LOCK();
+	return reset_count_;
+}
+void bq25186::notify_subscribers_(uint8_t start, const uint8_t *previous, uint8_t length) {
+	for(uint8_t index = start; index < start + length; index++) {
+		uint8_t changed = (previous[index - start] ^ registers[index]) & subscribed_bits_[index];
+		if(changed == 0 || (registers_known_ & (1U << index)) == 0) {
+			continue;								//Most reads change nothing anyone subscribed to
+		}
+		for(uint8_t subscriber = 0; subscriber < subscriber_count_; subscriber++) {
+			if(subscribers_[subscriber].reg == index && (subscribers_[subscriber].mask & changed)) {
+				subscribers_[subscriber].callback(previous[index - start] & subscribers_[subscriber].mask, registers[index] & subscribers_[subscriber].mask);
+			}
+		}
+	}
+}
+bool bq25186::subscribe(uint8_t index, uint8_t mask, void (*callback)(uint8_t, uint8_t)) {
+	BQ25186_LOCK();
+	if(subscriber_count_ == BQ25186_MAX_SUBSCRIBERS || index >= bq25186_number_of_registers_ || mask == 0 || callback == nullptr) {
+		return false;
+	}
+	subscribers_[subscriber_count_].reg = index;
+	subscribers_[subscriber_count_].mask = mask;
+	subscribers_[subscriber_count_].callback = callback;
+	subscriber_count_++;
+	subscribed_bits_[index] |= mask;
+	return true;
+}
+void bq25186::unsubscribe(void (*callback)(uint8_t, uint8_t)) {
+	BQ25186_LOCK();
+	uint8_t kept = 0;
+	memset(subscribed_bits_, 0, sizeof(subscribed_bits_));
+	for(uint8_t subscriber = 0; subscriber < subscriber_count_; subscriber++) {
+		if(subscribers_[subscriber].callback != callback) {
+			subscribers_[kept] = subscribers_[subscriber];	//Keep the table packed, in the order they subscribed
+			subscribed_bits_[subscribers_[kept].reg] |= subscribers_[kept].mask;
+			kept++;
+		}
+	}
+	subscriber_count_ = kept;
+}
+/*
+Retries are only made for transfers that start by setting the register pointer, a bare read can't be repeated as the pointer may have moved. A timeout
+or other error is what a device holding SDA low looks like, so the bus is asked to recover before retrying those. With a latency budget set, a retry
+or recovery is only started if the longest transfer and recovery seen so far would still finish within the budget.
+*/
+uint8_t bq25186::bus_transfer_(const uint8_t *writeData, uint8_t writeLength, uint8_t *readData, uint8_t readLength, bool stop) {
+	if(call_transferred_ && fits_budget_(worst_transfer_us_) == false) {
+		#if defined BQ25186_INCLUDE_STATISTICS
+		stats_.over_budget++;
+		#endif
+		last_bus_error_ = BQ25186_BUS_OVER_BUDGET;
+		return last_bus_error_;
+	}
+	call_transferred_ = true;
+	uint8_t i2cError = bus_attempt_(writeData, writeLength, readData, readLength, stop);
+	uint16_t backoff = retry_backoff_;
+	for(uint8_t retry = 0; i2cError != BQ25186_BUS_OK && retry < retries_ && writeLength > 0; retry++) {
+		bool recover = i2cError == BQ25186_BUS_TIMEOUT || i2cError == BQ25186_BUS_OTHER_ERROR;
+		if(fits_budget_((recover ? worst_recover_us_ : 0) + backoff + worst_transfer_us_) == false) {
+			#if defined BQ25186_INCLUDE_STATISTICS
+			stats_.over_budget++;
+			#endif
+			break;									//Give up with the last bus error rather than run late
+		}
+		if(recover) {
+			uint32_t recoverStart = micros();
+			bool recovered = bus_->recover();
+			uint32_t recoverTime = micros() - recoverStart;
+			if(recoverTime > worst_recover_us_) {
+				worst_recover_us_ = recoverTime;
+			}
+			#if defined BQ25186_INCLUDE_STATISTICS
+			if(recovered) {
+				stats_.recoveries++;
 			}
+			#else
+			(void)recovered;
 			#endif
 		}
+		delayMicroseconds(backoff);
+		backoff = backoff < bq25186_max_backoff_ / 2 ? backoff * 2 : bq25186_max_backoff_;
+		#if defined BQ25186_INCLUDE_STATISTICS
+		stats_.retries++;
+		#endif
+		i2cError = bus_attempt_(writeData, writeLength, readData, readLength, stop);
+	}
+	return i2cError;
+}
+uint8_t bq25186::bus_attempt_(const uint8_t *writeData, uint8_t writeLength, uint8_t *readData, uint8_t readLength, bool stop) {
+	uint32_t transferStart = micros();
+	uint8_t i2cError;
+	if(readLength == 0) {
+		i2cError = bus_->write(bq25186_i2c_address_, writeData, writeLength, stop);
+	} else if(writeLength == 0) {
+		i2cError = bus_->read(bq25186_i2c_address_, readData, readLength, stop);
+	} else {
+		i2cError = bus_->write_read(bq25186_i2c_address_, writeData, writeLength, readData, readLength, stop);
+	}
+	uint32_t transferTime = micros() - transferStart;
+	if(transferTime > worst_transfer_us_) {
+		worst_transfer_us_ = transferTime;
+	}
+	last_bus_error_ = i2cError;
+	if(i2cError == BQ25186_BUS_OK) {
+		last_bus_activity_ = millis();				//Any acknowledged transaction resets the watchdog, so this traffic counts as a keepalive
+	}
+	#if defined BQ25186_INCLUDE_STATISTICS
+	stats_.transactions++;
+	if(i2cError == BQ25186_BUS_OK) {
+		stats_.bytes_written += writeLength;
+		stats_.bytes_read += readLength;
+	} else {
+		stats_.errors[i2cError <= BQ25186_BUS_TIMEOUT ? i2cError : BQ25186_BUS_OTHER_ERROR]++;
+	}
+	if(stats_.transactions == 1 || transferTime < stats_.min_transfer_us) {
+		stats_.min_transfer_us = transferTime;
 	}
+	if(transferTime > stats_.max_transfer_us) {
+		stats_.max_transfer_us = transferTime;
+	}
+	stats_.total_transfer_us += transferTime;
+	#endif
+	return i2cError;
+}
+bool bq25186::fits_budget_(uint32_t microseconds) {
+	return latency_budget_ == 0 || (micros() - call_start_) + microseconds <= latency_budget_;
+}
+bq25186::call_timer_::call_timer_(bq25186 *charger) : charger_(charger) {
+	if(charger_->call_depth_++ == 0) {
+		charger_->call_start_ = micros();
+		charger_->call_transferred_ = false;
+		charger_->call_async_ = false;
+	}
+}
+bq25186::call_timer_::~call_timer_() {
+	if(charger_->call_depth_ == 1 && charger_->call_transferred_ && charger_->call_async_ == false && charger_->restore_due_()) {
+		charger_->call_start_ = micros();				//The restore has a latency budget of its own, and only calls already using the bus make one
+		charger_->call_transferred_ = false;
+		charger_->restore_config_();					//Once the call that saw the reset is finished with the bus
+	}
+	charger_->call_depth_--;
+}
+void bq25186::set_retries(uint8_t retries, uint16_t backoffMicroseconds) {
+	BQ25186_LOCK();
+	retries_ = retries;
+	retry_backoff_ = backoffMicroseconds < bq25186_max_backoff_ ? backoffMicroseconds : bq25186_max_backoff_;
+}
+void bq25186::set_write_verify(bool verify) {
+	BQ25186_LOCK();
+	verify_writes_ = verify;
+}
+void bq25186::set_latency_budget(uint32_t microseconds) {
+	BQ25186_LOCK();
+	latency_budget_ = microseconds;
+}
+uint8_t bq25186::get_last_error() {
+	BQ25186_LOCK();
+	return last_bus_error_;
+}
+#if defined BQ25186_INCLUDE_STATISTICS
+void bq25186::get_stats(bq25186_stats &stats) {
+	BQ25186_LOCK();
+	stats = stats_;
+	stats.average_transfer_us = stats_.transactions > 0 ? stats_.total_transfer_us / stats_.transactions : 0;
+}
+void bq25186::reset_stats() {
+	BQ25186_LOCK();
+	stats_ = bq25186_stats();
+}
+#endif
+#if BQ25186_LOG_LEVEL > BQ25186_LOG_NONE
+void bq25186::log_event_(uint8_t event, uint8_t reg, uint8_t mask, uint8_t oldValue, uint8_t newValue, uint8_t error) {
+	uint8_t index = (log_head_ + log_length_) % BQ25186_LOG_LENGTH;
+	if(log_length_ < BQ25186_LOG_LENGTH) {
+		log_length_++;
+	} else {
+		log_head_ = (log_head_ + 1) % BQ25186_LOG_LENGTH;	//Full, so lose the oldest record
+		log_dropped_++;
+	}
+	log_[index].timestamp = micros();
+	log_[index].event = event;
+	log_[index].reg = reg;
+	log_[index].mask = mask;
+	log_[index].old_value = oldValue;
+	log_[index].new_value = newValue;
+	log_[index].error = error;
+}
+bool bq25186::take_log_record(bq25186_log_record &record) {
+	BQ25186_LOCK();
+	if(log_length_ == 0) {
+		return false;
+	}
+	record = log_[log_head_];
+	log_head_ = (log_head_ + 1) % BQ25186_LOG_LENGTH;
+	log_length_--;
+	return true;
+}
+uint16_t bq25186::log_dropped() {
+	BQ25186_LOCK();
+	uint16_t dropped = log_dropped_;
+	log_dropped_ = 0;
+	return dropped;
+}
+#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
+static void bq25186_print_hex_(Stream &stream, uint8_t value) {
+	stream.print(value < 0x10 ? F("0x0") : F("0x"));
+	stream.print(value, HEX);
+}
+void bq25186::drain_log(Stream &stream) {
+	uint16_t dropped = log_dropped();
+	if(dropped > 0) {
+		stream.print(dropped);
+		stream.println(F(" BQ25186 log records lost"));
+	}
+	bq25186_log_record record;
+	while(take_log_record(record)) {			//The lock is only held while taking each record, not while printing
+		stream.print(record.timestamp);
+		stream.print(F("us "));
+		switch(record.event) {
+			case BQ25186_EVENT_BEGIN:
+				stream.print(record.new_value ? F("BQ25186 library started") : F("Unable to communicate with BQ25186"));
+			break;
+			case BQ25186_EVENT_RESET:
+				stream.print(F("Reset detected, restore register:"));
+				bq25186_print_hex_(stream, record.reg);
+				stream.print(F(" count:"));
+				stream.print(record.mask);
+			break;
+			case BQ25186_EVENT_READ:
+			case BQ25186_EVENT_COMMIT:
+				stream.print(record.event == BQ25186_EVENT_READ ? F("Read register:") : F("Commit register:"));
+				bq25186_print_hex_(stream, record.reg);
+				stream.print(F(" count:"));
+				stream.print(record.mask);
+			break;
+			default:
+				stream.print(record.event == BQ25186_EVENT_WRITE ? F("Write register:") : F("Stage register:"));
+				bq25186_print_hex_(stream, record.reg);
+				stream.print(F(" mask:"));
+				bq25186_print_hex_(stream, record.mask);
+				stream.print(F(" value:"));
+				bq25186_print_hex_(stream, record.old_value);
+				stream.print(F("->"));
+				bq25186_print_hex_(stream, record.new_value);
+			break;
+		}
+		switch(record.error) {
+			case BQ25186_BUS_OK:
+				stream.println();
+			break;
+			case BQ25186_BUS_DATA_TOO_LONG:
+				stream.println(F(" failed, data too long to fit in transmit buffer"));
+			break;
+			case BQ25186_BUS_NACK_ADDRESS:
+				stream.println(F(" failed, received NACK on transmit of address"));
+			break;
+			case BQ25186_BUS_NACK_DATA:
+				stream.println(F(" failed, received NACK on transmit of data"));
+			break;
+			case BQ25186_BUS_TIMEOUT:
+				stream.println(F(" failed, timeout"));
+			break;
+			default:
+				stream.println(F(" failed, other error"));
+			break;
+		}
+	}
+}
+#endif
+#endif
+bool bq25186::read_registers_(uint8_t start, uint8_t length, bool stop) {
+	BQ25186_LOCK();
+	if(async_state_ == BQ25186_ASYNC_READ_DATA) {
+		async_state_ = BQ25186_ASYNC_READ_ADDRESS;	//This moves the register pointer, so a queued read must send it again
+	}
+	if(start == 0x00 && length == bq25186_number_of_status_registers_ && reset_sentinel_ != 0 &&
+		(registers_dirty_ & (((1U << (reset_sentinel_ + 1)) - 1) & ~bq25186_status_registers_mask_)) == 0) {
+		length = reset_sentinel_ + 1;					//Extend the status burst to the sentinel, unless that would overwrite staged changes
+	}
+	uint8_t buffer[bq25186_number_of_registers_];				//Only update the cache if the whole read succeeds
+	if(bus_transfer_(&start, 1, buffer, length, stop) == BQ25186_BUS_OK) {	//Send the register to begin reading from then read only the registers asked for
+		registers_received_(start, buffer, length);
+		BQ25186_LOG(BQ25186_LOG_TRACE, BQ25186_EVENT_READ, start, length, 0, 0, BQ25186_BUS_OK);
+		return true;
+	}
+	BQ25186_LOG(BQ25186_LOG_ERROR, BQ25186_EVENT_READ, start, length, 0, 0, last_bus_error_);
 	return false;
 }
 uint8_t bq25186::read_bitmasked_value_from_register_(uint8_t index, uint8_t mask) {
-	if(auto_refresh_all_registers_()) {			//Only refreshes the registers if they have not been read recently
+	BQ25186_LOCK();
+	bool refreshed;
+	if(index < bq25186_number_of_status_registers_) {
+		refreshed = auto_refresh_registers_(0x00, bq25186_number_of_status_registers_);	//Status registers are read together as one short burst
+	} else {
+		refreshed = auto_refresh_registers_(index, 1);	//Configuration registers are read individually
+	}
+	if(refreshed) {			//Only refreshes the registers if they have not been read recently
 		return registers[index] & mask;
 	} else {
 		return BQ25186_I2C_ERROR;
 	}
 }
 bool bq25186::write_register_(uint8_t registerIndex, uint8_t registerValue, bool stop) {
-	i2cPort_->beginTransmission(bq25186_i2c_address_);	//Start I2C transmission
-	uint8_t i2cData[2] = {registerIndex, registerValue};//Put the address and value together to send
-	i2cPort_->write(i2cData,2);							//Send the register and value
-	uint8_t i2cError = i2cPort_->endTransmission(stop);	//End the transmission, with a stop
-	if(i2cError == 0) {									//Check that it was sent
-		#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-			if(debug_uart_ != nullptr) {
-				debug_uart_->println(F("Register write succeeded"));
-			}
+	return write_registers_(registerIndex, &registerValue, 1, stop);
+}
+bool bq25186::write_registers_(uint8_t start, const uint8_t *values, uint8_t length, bool stop) {
+	BQ25186_LOCK();
+	if(async_state_ == BQ25186_ASYNC_READ_DATA) {
+		async_state_ = BQ25186_ASYNC_READ_ADDRESS;	//This moves the register pointer, so a queued read must send it again
+	}
+	uint8_t i2cData[bq25186_number_of_registers_ + 1];	//Put the first register and values together to send
+	i2cData[0] = start;									//The BQ25186 auto-increments the register after each byte
+	memcpy(&i2cData[1], values, length);
+	for(uint8_t attempt = 0; ; attempt++) {
+		if(bus_transfer_(i2cData, length + 1, nullptr, 0, stop) != BQ25186_BUS_OK) {	//Send the register and values, the callers log the result as they know what was being written
+			return false;
+		}
+		if(verify_writes_ == false || write_verified_(start, values, length)) {
+			track_config_(start, values, length);
+			return true;
+		}
+		if(last_bus_error_ == BQ25186_BUS_OK) {
+			last_bus_error_ = BQ25186_BUS_VERIFY_FAILED;
+			#if defined BQ25186_INCLUDE_STATISTICS
+			stats_.verify_failures++;
+			#endif
+		}
+		registers_fresh_ &= ~(((1U << length) - 1) << start);	//Unknown what the device now holds, so re-read on next use
+		if(attempt >= retries_ || last_bus_error_ != BQ25186_BUS_VERIFY_FAILED) {
+			return false;
+		}
+		#if defined BQ25186_INCLUDE_STATISTICS
+		stats_.retries++;
 		#endif
-		return true;
 	}
-	#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-		if(debug_uart_ != nullptr) {
-			debug_uart_->print(F("Register write failed, error:"));
-			switch (i2cError) {
-				  case 1:
-					debug_uart_->println(F("data too long to fit in transmit buffer"));
-					break;
-				  case 2:
-					debug_uart_->println(F("received NACK on transmit of address"));
-					break;
-				  case 3:
-					debug_uart_->println(F("received NACK on transmit of data"));
-					break;
-				  case 4:
-					debug_uart_->println(F("other error"));
-					break;
-				  case 5:
-					debug_uart_->println(F("timeout"));
-					break;
-				  default:
-					debug_uart_->println(F("unknown"));
-					break;
+}
+bool bq25186::write_verified_(uint8_t start, const uint8_t *values, uint8_t length) {
+	if(start <= 0x09 && start + length > 0x09 && (values[0x09 - start] & BQ25186_I2C_BITMASK_7_5)) {
+		return true;									//The device resets or turns off, so there is nothing to read back
+	}
+	uint8_t readBack[bq25186_number_of_registers_];
+	if(bus_transfer_(&start, 1, readBack, length) != BQ25186_BUS_OK) {
+		return false;
+	}
+	for(uint8_t index = 0; index < length; index++) {
+		if((readBack[index] ^ values[index]) & bq25186_config_bits_[start + index]) {
+			return false;
+		}
+	}
+	return true;
+}
+void bq25186::begin_config() {
+	BQ25186_LOCK();
+	config_transaction_ = true;
+}
+bool bq25186::commit() {
+	BQ25186_LOCK();
+	config_transaction_ = false;
+	bool success = true;
+	uint8_t index = 0;
+	while(index < bq25186_number_of_registers_) {
+		if(registers_dirty_ & (1U << index)) {			//Find the next run of contiguous changed registers
+			uint8_t start = index;
+			while(index < bq25186_number_of_registers_ && (registers_dirty_ & (1U << index))) {
+				index++;
 			}
+			if(write_registers_(start, &registers[start], index - start)) {
+				BQ25186_LOG(BQ25186_LOG_INFO, BQ25186_EVENT_COMMIT, start, index - start, 0, 0, BQ25186_BUS_OK);
+			} else {
+				BQ25186_LOG(BQ25186_LOG_ERROR, BQ25186_EVENT_COMMIT, start, index - start, 0, 0, last_bus_error_);
+				success = false;
+				registers_fresh_ &= ~(((1U << (index - start)) - 1) << start);	//Unknown what the device now holds, so re-read on next use
+			}
+		} else {
+			index++;
 		}
-	#endif
-	return false;
+	}
+	if((registers_dirty_ & (1U << 0x09)) && reset_requested_(registers[0x09])) {
+		reset_requested_cache_();
+	}
+	registers_dirty_ = 0;
+	return success;
+}
+void bq25186::abort_config() {
+	BQ25186_LOCK();
+	config_transaction_ = false;
+	registers_fresh_ &= ~registers_dirty_;				//Staged values were never written, so re-read on next use
+	registers_dirty_ = 0;
+}
+#if defined(ARDUINO)
+bool bq25186::enable_interrupt(uint8_t pin) {
+	if(interrupt_instance_ != nullptr && interrupt_instance_ != this) {	//Only one handler is available
+		return false;
+	}
+	interrupt_instance_ = this;
+	interrupt_pin_ = pin;
+	interrupt_pending_ = true;					//Read the status on the first service() to have something to compare with
+	pinMode(pin, INPUT_PULLUP);					//INT is open drain and pulses low on an event
+	attachInterrupt(digitalPinToInterrupt(pin), interrupt_handler_, FALLING);
+	return true;
+}
+void bq25186::disable_interrupt() {
+	if(interrupt_pin_ != -1) {
+		detachInterrupt(digitalPinToInterrupt(interrupt_pin_));
+		interrupt_pin_ = -1;
+	}
+	if(interrupt_instance_ == this) {
+		interrupt_instance_ = nullptr;
+	}
 }
-bool bq25186::write_bitmasked_value_to_register_(uint8_t index, uint8_t mask, uint8_t value) {
-	#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-	if(debug_uart_ != nullptr) {
-		debug_uart_->print(F("Writing bit masked value to register:"));
-		printHex(index);
-		debug_uart_->print(F(" mask:"));
-		printBinary(mask);
-		debug_uart_->print(F(" value:"));
-		printBinary(value);
-		debug_uart_->println();
+#endif
+void BQ25186_ISR_ATTR bq25186::interrupt_handler_() {
+	if(interrupt_instance_ != nullptr) {
+		interrupt_instance_->interrupt_pending_ = true;
 	}
-	#endif
-	auto_refresh_all_registers_();			//Only refresh the registers if they have not been read recently
-	#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-	if(debug_uart_ != nullptr) {
-		debug_uart_->print(F("Current value:"));
-		printHex(registers[index]);
-		debug_uart_->print('/');
-		printBinary(registers[index]);
+}
+uint32_t bq25186::get_watchdog_period() {
+	BQ25186_LOCK();
+	uint32_t period;
+	switch(cached_field_<bq25186_fields::watchdog_sel>()) {	//From the cache, these only change when written or on a reset
+		case BQ25186_WATCHDOG_160S_DEFAULTS:
+		case BQ25186_WATCHDOG_160S_HW_RESET:
+			period = 160e3;
+		break;
+		case BQ25186_WATCHDOG_40S_DEFAULTS:
+			period = 40e3;
+		break;
+		default:
+			period = 0;
+		break;
+	}
+	if(cached_field_<bq25186_fields::i2c_watchdog_mode>() == BQ25186_SYS_WATCHDOG_15S_ENABLE) {
+		period = 15e3;
+	}
+	return period;
+}
+uint32_t bq25186::next_keepalive() {
+	BQ25186_LOCK();
+	uint32_t period = get_watchdog_period();
+	if(period == 0) {
+		return 0xffffffff;
+	}
+	uint32_t interval = period > keepalive_margin_ ? period - keepalive_margin_ : 0;
+	uint32_t elapsed = millis() - last_bus_activity_;
+	return elapsed < interval ? interval - elapsed : 0;
+}
+void bq25186::set_keepalive_margin(uint32_t milliseconds) {
+	BQ25186_LOCK();
+	keepalive_margin_ = milliseconds;
+}
+bool bq25186::keepalive() {
+	BQ25186_LOCK();
+	const uint16_t watchdogRegisters = (1U << 0x07) | (1U << 0x0a);
+	if((registers_fresh_ & watchdogRegisters) != watchdogRegisters) {	//Only after a reset invalidated the cache, and the read feeds the watchdog anyway
+		bq25186_communicating_ok_ = read_registers_(0x07, 0x0a - 0x07 + 1);
+		return bq25186_communicating_ok_;
 	}
+	if(next_keepalive() > 0) {
+		return true;								//Other traffic has kept the watchdog fed, or it is disabled
+	}
+	if(async_queue_length_ > 0) {
+		update();									//Piggyback on queued work rather than adding a transaction
+		return bq25186_communicating_ok_;
+	}
+	#if defined BQ25186_INCLUDE_STATISTICS
+	stats_.keepalives++;
 	#endif
-	uint8_t newValue = (registers[index] & (mask ^ 0xff)) | (value & mask);
-	#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
-	if(debug_uart_ != nullptr) {
-		debug_uart_->print(F(" new value:"));
-		printHex(newValue);
-		debug_uart_->print('/');
-		printBinaryLn(newValue);
+	uint8_t pointer = 0x00;							//The cheapest valid transaction, setting the register pointer with no data
+	bq25186_communicating_ok_ = bus_transfer_(&pointer, 1, nullptr, 0) == BQ25186_BUS_OK;
+	return bq25186_communicating_ok_;
+}
+bool bq25186::service() {
+	BQ25186_LOCK();
+	if(interrupt_pending_ == false) {
+		keepalive();								//Does nothing unless the watchdog needs feeding
+		return false;
 	}
+	interrupt_pending_ = false;					//Cleared before reading so an event during the read is not lost
+	bool previousValid = (registers_fresh_ & bq25186_status_registers_mask_) == bq25186_status_registers_mask_;
+	uint8_t previousStatus = registers[0x00];
+	if(read_registers_(0x00, bq25186_number_of_status_registers_) == false) {
+		bq25186_communicating_ok_ = false;
+		return true;
+	}
+	bq25186_communicating_ok_ = true;
+	if(previousValid) {
+		if(charge_state_callback_ != nullptr && bq25186_fields::chg_stat::extract(previousStatus ^ registers[0x00])) {
+			charge_state_callback_(cached_field_<bq25186_fields::chg_stat>());
+		}
+		if(power_good_lost_callback_ != nullptr && (previousStatus & BQ25186_POWER_GOOD) && (registers[0x00] & BQ25186_POWER_GOOD) == BQ25186_POWER_NOT_GOOD) {
+			power_good_lost_callback_();
+		}
+	}
+	if(fault_callback_ != nullptr && registers[0x02] != 0) {	//Fault flags are cleared on read, so each one is a new event
+		fault_callback_(registers[0x02]);
+	}
+	return true;
+}
+bool bq25186::queue_read(uint8_t start, uint8_t length, void (*callback)(bool)) {
+	if(start + length > bq25186_number_of_registers_ || length == 0) {
+		return false;
+	}
+	return queue_request_(BQ25186_ASYNC_READ_ADDRESS, start, length, 0, 0, callback);
+}
+bool bq25186::queue_write(uint8_t index, uint8_t mask, uint8_t value, void (*callback)(bool)) {
+	if(index < bq25186_number_of_status_registers_ || index >= bq25186_number_of_registers_) {
+		return false;
+	}
+	return queue_request_(BQ25186_ASYNC_WRITE, index, 1, mask, value, callback);
+}
+bool bq25186::queue_request_(uint8_t type, uint8_t start, uint8_t length, uint8_t mask, uint8_t value, void (*callback)(bool)) {
+	{
+		BQ25186_LOCK();
+		if(async_queue_length_ == BQ25186_ASYNC_QUEUE_LENGTH) {		//Queue is full
+			return false;
+		}
+		bq25186_async_request &request = async_queue_[(async_queue_head_ + async_queue_length_) % BQ25186_ASYNC_QUEUE_LENGTH];
+		request.type = type;
+		request.start = start;
+		request.length = length;
+		request.mask = mask;
+		request.value = value;
+		request.callback = callback;
+		async_queue_length_++;
+	}
+	#if defined BQ25186_THREAD_SAFE
+	wake_worker_();
 	#endif
+	return true;
+}
+bool bq25186::update() {
+	BQ25186_LOCK();
+	if(call_depth_ == 1) {
+		call_async_ = true;								//Any restore is a phase of its own below, not tacked on to this one
+	}
+	if(async_state_ == BQ25186_ASYNC_IDLE) {
+		if(restore_due_()) {
+			restore_config_();
+			return async_queue_length_ > 0;
+		}
+		if(async_queue_length_ == 0) {
+			return false;
+		}
+		bq25186_async_request &request = async_queue_[async_queue_head_];
+		if(request.type == BQ25186_ASYNC_WRITE && (registers_fresh_ & (1U << request.start)) == 0) {
+			async_state_ = BQ25186_ASYNC_READ_ADDRESS;	//Need the current value before a read-modify-write
+		} else {
+			async_state_ = request.type;
+		}
+	}
+	bq25186_async_request &request = async_queue_[async_queue_head_];
+	bool success = true;
+	switch(async_state_) {
+		case BQ25186_ASYNC_READ_ADDRESS:				//Phase 1, set the register pointer
+			if(bus_transfer_(&request.start, 1, nullptr, 0) == BQ25186_BUS_OK) {
+				async_state_ = BQ25186_ASYNC_READ_DATA;
+				return true;
+			}
+			success = false;
+		break;
+		case BQ25186_ASYNC_READ_DATA:					//Phase 2, read the data
+			{
+				uint8_t length = request.type == BQ25186_ASYNC_WRITE ? 1 : request.length;
+				uint8_t buffer[bq25186_number_of_registers_];
+				if(bus_transfer_(nullptr, 0, buffer, length) == BQ25186_BUS_OK) {
+					registers_received_(request.start, buffer, length);
+					if(request.type == BQ25186_ASYNC_WRITE) {
+						async_state_ = BQ25186_ASYNC_WRITE;	//Now do the write itself on the next update
+						return true;
+					}
+				} else {
+					success = false;
+				}
+			}
+		break;
+		case BQ25186_ASYNC_WRITE:						//Single phase, write the new register value
+			{
+				uint8_t newValue = (registers[request.start] & (request.mask ^ 0xff)) | (request.value & request.mask);
+				uint8_t i2cData[2] = {request.start, newValue};
+				if(bus_transfer_(i2cData, 2, nullptr, 0) == BQ25186_BUS_OK) {
+					registers[request.start] = newValue;
+					registers_fresh_ |= (1U << request.start);
+					track_config_(request.start, &newValue, 1);
+					if(request.start == 0x09 && reset_requested_(newValue)) {
+						reset_requested_cache_();
+					}
+				} else {
+					success = false;
+				}
+			}
+		break;
+	}
+	bq25186_communicating_ok_ = success;
+	void (*callback)(bool) = request.callback;
+	async_queue_head_ = (async_queue_head_ + 1) % BQ25186_ASYNC_QUEUE_LENGTH;	//Request is complete, remove it before the callback so it can queue more
+	async_queue_length_--;
+	async_state_ = BQ25186_ASYNC_IDLE;
+	if(callback != nullptr) {
+		callback(success);
+	}
+	return async_queue_length_ > 0 || restore_due_();	//A reset this request saw is restored on the next call
+}
+bool bq25186::async_busy() {
+	BQ25186_LOCK();
+	return async_queue_length_ > 0;
+}
+void bq25186::set_charge_state_callback(void (*callback)(uint8_t)) {
+	BQ25186_LOCK();
+	charge_state_callback_ = callback;
+}
+void bq25186::set_power_good_lost_callback(void (*callback)()) {
+	BQ25186_LOCK();
+	power_good_lost_callback_ = callback;
+}
+void bq25186::set_fault_callback(void (*callback)(uint8_t)) {
+	BQ25186_LOCK();
+	fault_callback_ = callback;
+}
+bool bq25186::reset_requested_(uint8_t shipRstValue) {
+	return (shipRstValue & BQ25186_I2C_BITMASK_7) == BQ25186_SOFTWARE_RESET || (shipRstValue & BQ25186_I2C_BITMASK_6_5) == BQ25186_HARDWARE_RESET;
+}
+bool bq25186::write_bitmasked_value_to_register_(uint8_t index, uint8_t mask, uint8_t value) {
+	BQ25186_LOCK();
+	if(auto_refresh_registers_(index, 1) == false) {	//Only refresh the register if it has not been read recently
+		BQ25186_LOG(BQ25186_LOG_ERROR, config_transaction_ ? BQ25186_EVENT_STAGE : BQ25186_EVENT_WRITE, index, mask, registers[index], value, last_bus_error_);
+		return false;							//Never write or stage a change on top of an unknown value, it would change the other fields
+	}
+	uint8_t oldValue = registers[index];
+	uint8_t newValue = (oldValue & (mask ^ 0xff)) | (value & mask);
+	if(config_transaction_) {
+		registers[index] = newValue;				//Stage the change until commit()
+		registers_dirty_ |= (1U << index);
+		BQ25186_LOG(BQ25186_LOG_TRACE, BQ25186_EVENT_STAGE, index, mask, oldValue, newValue, BQ25186_BUS_OK);
+		return true;
+	}
 	if(write_register_(index, newValue)) {
-		registers[index] = newValue;
+		BQ25186_LOG(BQ25186_LOG_TRACE, BQ25186_EVENT_WRITE, index, mask, oldValue, newValue, BQ25186_BUS_OK);
+		registers[index] = newValue;				//Write-through, the cached copy stays valid
+		registers_fresh_ |= (1U << index);
+		if(index == 0x09 && reset_requested_(newValue)) {
+			reset_requested_cache_();				//The device has reset its registers to default, so nothing cached is valid
+		}
 		return true;
 	}
+	BQ25186_LOG(BQ25186_LOG_ERROR, BQ25186_EVENT_WRITE, index, mask, oldValue, newValue, last_bus_error_);
 	return false;
 }
 //Register 0x00
 uint8_t bq25186::ts_open_stat() {
-	return read_bitmasked_value_from_register_(0x00,BQ25186_I2C_BITMASK_7);
+	return get_field<bq25186_fields::ts_open_stat>();
 }
 /*
 Get charging status, returns...
@@ -226,309 +1366,381 @@ Get charging status, returns...
 	BQ25186_I2C_ERROR
 */
 uint8_t bq25186::chg_stat() {
-	return read_bitmasked_value_from_register_(0x00,BQ25186_I2C_BITMASK_6_5);
+	return get_field<bq25186_fields::chg_stat>();
 }
 uint8_t bq25186::ilim_active_stat() {
-	return read_bitmasked_value_from_register_(0x00,BQ25186_I2C_BITMASK_4);
+	return get_field<bq25186_fields::ilim_active_stat>();
 }
 uint8_t bq25186::vdppm_active_stat() {
-	return read_bitmasked_value_from_register_(0x00,BQ25186_I2C_BITMASK_3);
+	return get_field<bq25186_fields::vdppm_active_stat>();
 }
 uint8_t bq25186::vindpm_active_stat() {
-	return read_bitmasked_value_from_register_(0x00,BQ25186_I2C_BITMASK_2);
+	return get_field<bq25186_fields::vindpm_active_stat>();
 }
 uint8_t bq25186::thermreg_active_stat() {
-	return read_bitmasked_value_from_register_(0x00,BQ25186_I2C_BITMASK_1);
+	return get_field<bq25186_fields::thermreg_active_stat>();
 }
 uint8_t bq25186::vin_pgood_stat() {
-	return read_bitmasked_value_from_register_(0x00,BQ25186_I2C_BITMASK_0);
+	return get_field<bq25186_fields::vin_pgood_stat>();
 }
 //Register 0x01
 uint8_t bq25186::vin_ovp_stat() {
-	return read_bitmasked_value_from_register_(0x01,BQ25186_I2C_BITMASK_7);
+	return get_field<bq25186_fields::vin_ovp_stat>();
 }
 uint8_t bq25186::buvlo_stat() {
-	return read_bitmasked_value_from_register_(0x01,BQ25186_I2C_BITMASK_6);
+	return get_field<bq25186_fields::buvlo_stat>();
 }
 uint8_t bq25186::ts_stat() {
-	return read_bitmasked_value_from_register_(0x01,BQ25186_I2C_BITMASK_4_3);
+	return get_field<bq25186_fields::ts_stat>();
 }
 uint8_t bq25186::safety_tmr_fault_flag() {
-	return read_bitmasked_value_from_register_(0x01,BQ25186_I2C_BITMASK_2);
+	return get_field<bq25186_fields::safety_tmr_fault_flag>();
 }
 uint8_t bq25186::wake1_flag() {
-	return read_bitmasked_value_from_register_(0x01,BQ25186_I2C_BITMASK_1);
+	return get_field<bq25186_fields::wake1_flag>();
 }
 uint8_t bq25186::wake2_flag() {
-	return read_bitmasked_value_from_register_(0x01,BQ25186_I2C_BITMASK_0);
+	return get_field<bq25186_fields::wake2_flag>();
 }
 //Register 0x02
 uint8_t bq25186::ts_fault() {
-	return read_bitmasked_value_from_register_(0x02,BQ25186_I2C_BITMASK_7);
+	return get_field<bq25186_fields::ts_fault>();
 }
 uint8_t bq25186::ilim_active_flag() {
-	return read_bitmasked_value_from_register_(0x02,BQ25186_I2C_BITMASK_6);
+	return get_field<bq25186_fields::ilim_active_flag>();
 }
 uint8_t bq25186::vdppm_active_flag() {
-	return read_bitmasked_value_from_register_(0x02,BQ25186_I2C_BITMASK_5);
+	return get_field<bq25186_fields::vdppm_active_flag>();
 }
 uint8_t bq25186::vindpm_active_flag() {
-	return read_bitmasked_value_from_register_(0x02,BQ25186_I2C_BITMASK_4);
+	return get_field<bq25186_fields::vindpm_active_flag>();
 }
 uint8_t bq25186::thermreg_active_flag() {
-	return read_bitmasked_value_from_register_(0x02,BQ25186_I2C_BITMASK_3);
+	return get_field<bq25186_fields::thermreg_active_flag>();
 }
 uint8_t bq25186::vin_ovp_fault_flag() {
-	return read_bitmasked_value_from_register_(0x02,BQ25186_I2C_BITMASK_2);
+	return get_field<bq25186_fields::vin_ovp_fault_flag>();
 }
 uint8_t bq25186::buvlo_fault_flag() {
-	return read_bitmasked_value_from_register_(0x02,BQ25186_I2C_BITMASK_1);
+	return get_field<bq25186_fields::buvlo_fault_flag>();
 }
 uint8_t bq25186::bat_ocp_fault() {
-	return read_bitmasked_value_from_register_(0x02,BQ25186_I2C_BITMASK_0);
+	return get_field<bq25186_fields::bat_ocp_fault>();
 }
 //Register 0x03
 uint8_t bq25186::get_pg_pin_mode() {
-	return read_bitmasked_value_from_register_(0x03,BQ25186_I2C_BITMASK_7);
+	return get_field<bq25186_fields::pg_pin_mode>();
 }
 bool bq25186::set_pg_pin_mode(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x03, BQ25186_I2C_BITMASK_7, value);
+	return set_field<bq25186_fields::pg_pin_mode>(value);
 }
-float bq25186::get_vbatreg() {
-	uint8_t vbatreg = read_bitmasked_value_from_register_(0x03,BQ25186_I2C_BITMASK_6_0);
+uint16_t bq25186::get_vbatreg_mv() {
+	uint8_t vbatreg = get_field<bq25186_fields::vbatreg>();
 	if(vbatreg != BQ25186_I2C_ERROR) {
-		return 3.5 + (float(vbatreg)*0.01);
+		return decode_vbatreg_(vbatreg);
 	} else {
 		return 0;
 	}
 }
+uint16_t bq25186::decode_vbatreg_(uint8_t value) {
+	return 3500 + uint16_t(value) * 10;
+}
+bool bq25186::set_vbatreg_mv(uint16_t millivolts) {
+	if(millivolts >= 3500 && millivolts <= 4650) {
+		return set_field<bq25186_fields::vbatreg>(uint8_t((millivolts - 3500 + 5) / 10));	//Rounded, not truncated
+	}
+	return false;
+}
+#if defined BQ25186_INCLUDE_FLOAT_API
+float bq25186::get_vbatreg() {
+	return get_vbatreg_mv() / 1000.0;
+}
 bool bq25186::set_vbatreg(float voltage) {
 	if(voltage >= 3.5 && voltage <= 4.65) {
-		return write_bitmasked_value_to_register_(0x03, BQ25186_I2C_BITMASK_6_0, uint8_t((voltage-3.5)*100));
+		return set_vbatreg_mv(uint16_t(voltage * 1000 + 0.5));
 	}
 	return false;
 }
+#endif
 //Register 0x04
 uint8_t bq25186::get_chg_dis() {
-	return read_bitmasked_value_from_register_(0x04,BQ25186_I2C_BITMASK_7);
+	return get_field<bq25186_fields::chg_dis>();
 }
 bool bq25186::set_chg_dis(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x04, BQ25186_I2C_BITMASK_7, value);
+	return set_field<bq25186_fields::chg_dis>(value);
 }
 uint16_t bq25186::get_ichg() {
-	uint8_t maskedRegisterValue = read_bitmasked_value_from_register_(0x04,BQ25186_I2C_BITMASK_6_0);
+	uint8_t maskedRegisterValue = get_field<bq25186_fields::ichg>();
 	if(maskedRegisterValue == BQ25186_I2C_ERROR) {
 		return 0;
-	} else if(maskedRegisterValue > 31) {
-		return 40+((maskedRegisterValue-31)*10);
+	}
+	return decode_ichg_(maskedRegisterValue);
+}
+uint16_t bq25186::decode_ichg_(uint8_t value) {
+	if(value > 31) {
+		return 40+((value-31)*10);
 	} else {
-		return (maskedRegisterValue+5);
+		return (value+5);
 	}
 }
+/*
+ICHG is 1mA steps from 5mA to 36mA then 10mA steps from 50mA to 1000mA, so values in the gap go to whichever of 36mA and 50mA is nearer
+*/
 bool bq25186::set_ichg(uint16_t value) {
-	if(value <= 1000) {
+	if(value >= 5 && value <= 1000) {
 		uint8_t maskedRegisterValue = 0;
-		if(value > 35) {
-			maskedRegisterValue = 32+((value-50)/10);
+		if(value <= 36) {
+			maskedRegisterValue = value - 5;
+		} else if(value < 43) {
+			maskedRegisterValue = 31;
+		} else if(value < 50) {
+			maskedRegisterValue = 32;
 		} else {
-			maskedRegisterValue = value-5;
+			maskedRegisterValue = 31 + (value - 35) / 10;	//Rounded to the nearest 10mA
 		}
-		return write_bitmasked_value_to_register_(0x04, BQ25186_I2C_BITMASK_6_0, maskedRegisterValue);
+		return set_field<bq25186_fields::ichg>(maskedRegisterValue);
 	}
 	return false;
 }
 //Register 0x05
 uint8_t bq25186::get_en_fc_mode() {
-	return read_bitmasked_value_from_register_(0x05,BQ25186_I2C_BITMASK_7);
+	return get_field<bq25186_fields::en_fc_mode>();
 }
 bool bq25186::set_en_fc_mode(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x05, BQ25186_I2C_BITMASK_7, value);
+	return set_field<bq25186_fields::en_fc_mode>(value);
 }
 uint8_t bq25186::get_iprechg() {
-	return read_bitmasked_value_from_register_(0x05,BQ25186_I2C_BITMASK_6);
+	return get_field<bq25186_fields::iprechg>();
 }
 bool bq25186::set_iprechg(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x05, BQ25186_I2C_BITMASK_6, value);
+	return set_field<bq25186_fields::iprechg>(value);
 }
 uint8_t bq25186::get_iterm() {
-	return read_bitmasked_value_from_register_(0x05,BQ25186_I2C_BITMASK_5_4);
+	return get_field<bq25186_fields::iterm>();
 }
 bool bq25186::set_iterm(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x05, BQ25186_I2C_BITMASK_5_4, value);
+	return set_field<bq25186_fields::iterm>(value);
+}
+uint8_t bq25186::get_iterm_percent() {
+	return to_units(bq25186_units::iterm, get_field<bq25186_fields::iterm>());
+}
+bool bq25186::set_iterm_percent(uint8_t percent) {
+	if(percent == 0) {
+		return set_field<bq25186_fields::iterm>(BQ25186_ITERM_DISABLE);
+	}
+	return set_field<bq25186_fields::iterm>(from_units(bq25186_units::iterm, percent));
 }
 uint8_t bq25186::get_vindpm() {
-	return read_bitmasked_value_from_register_(0x05,BQ25186_I2C_BITMASK_3_2);
+	return get_field<bq25186_fields::vindpm>();
 }
 bool bq25186::set_vindpm(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x05, BQ25186_I2C_BITMASK_3_2, value);
+	return set_field<bq25186_fields::vindpm>(value);
+}
+uint16_t bq25186::get_vindpm_mv() {
+	return to_units(bq25186_units::vindpm, get_field<bq25186_fields::vindpm>());
+}
+bool bq25186::set_vindpm_mv(uint16_t millivolts) {
+	return set_field<bq25186_fields::vindpm>(from_units(bq25186_units::vindpm, millivolts));
 }
 uint8_t bq25186::get_therm_reg() {
-	return read_bitmasked_value_from_register_(0x05,BQ25186_I2C_BITMASK_1_0);
+	return get_field<bq25186_fields::therm_reg>();
 }
 bool bq25186::set_therm_reg(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x05, BQ25186_I2C_BITMASK_1_0, value);
+	return set_field<bq25186_fields::therm_reg>(value);
 }
 //Register 0x06
 uint8_t bq25186::get_ibat_ocp() {
-	return read_bitmasked_value_from_register_(0x06,BQ25186_I2C_BITMASK_7_6);
+	return get_field<bq25186_fields::ibat_ocp>();
 }
 bool bq25186::set_ibat_ocp(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x06, BQ25186_I2C_BITMASK_7_6, value);
+	return set_field<bq25186_fields::ibat_ocp>(value);
+}
+uint16_t bq25186::get_ibat_ocp_ma() {
+	return to_units(bq25186_units::ibat_ocp, get_field<bq25186_fields::ibat_ocp>());
 }
+bool bq25186::set_ibat_ocp_ma(uint16_t milliamps) {
+	return set_field<bq25186_fields::ibat_ocp>(from_units(bq25186_units::ibat_ocp, milliamps));
+}
+uint16_t bq25186::get_buvlo_mv() {
+	return to_units(bq25186_units::buvlo, get_field<bq25186_fields::buvlo>());
+}
+bool bq25186::set_buvlo_mv(uint16_t millivolts) {
+	return set_field<bq25186_fields::buvlo>(from_units(bq25186_units::buvlo, millivolts));
+}
+#if defined BQ25186_INCLUDE_FLOAT_API
 float bq25186::get_buvlo() {
-	uint8_t buvlo = read_bitmasked_value_from_register_(0x06,BQ25186_I2C_BITMASK_5_3);
-	if(buvlo != BQ25186_I2C_ERROR) {
-		switch(buvlo) {
-		case BQ25186_BUVLO_30A:
-			return 3.0;
-		break;
-		case BQ25186_BUVLO_30B:
-			return 3.0;
-		break;
-		case BQ25186_BUVLO_30C:
-			return 3.0;
-		break;
-		case BQ25186_BUVLO_28:
-			return 2.8;
-		break;
-		case BQ25186_BUVLO_26:
-			return 2.6;
-		break;
-		case BQ25186_BUVLO_24:
-			return 2.4;
-		break;
-		case BQ25186_BUVLO_22:
-			return 2.2;
-		break;
-		case BQ25186_BUVLO_20:
-			return 2.0;
-		break;
-		}
-	}
-	return 0;
+	return get_buvlo_mv() / 1000.0;
 }
 bool bq25186::set_buvlo(float value) {
-	if(value > 2.8) {
-		return write_bitmasked_value_to_register_(0x06, BQ25186_I2C_BITMASK_5_3, BQ25186_BUVLO_30A);
-	} else if(value > 2.6) {
-		return write_bitmasked_value_to_register_(0x06, BQ25186_I2C_BITMASK_5_3, BQ25186_BUVLO_28);
-	} else if(value > 2.4) {
-		return write_bitmasked_value_to_register_(0x06, BQ25186_I2C_BITMASK_5_3, BQ25186_BUVLO_26);
-	} else if(value > 2.2) {
-		return write_bitmasked_value_to_register_(0x06, BQ25186_I2C_BITMASK_5_3, BQ25186_BUVLO_24);
-	} else if(value > 2.0) {
-		return write_bitmasked_value_to_register_(0x06, BQ25186_I2C_BITMASK_5_3, BQ25186_BUVLO_22);		
-	} else {
-		return write_bitmasked_value_to_register_(0x06, BQ25186_I2C_BITMASK_5_3, BQ25186_BUVLO_20);
-	}
+	return set_buvlo_mv(value > 0 ? uint16_t(value * 1000 + 0.5) : 0);
 }
+#endif
 uint8_t bq25186::get_chg_status_int_mask() {
-	return read_bitmasked_value_from_register_(0x06,BQ25186_I2C_BITMASK_2);
+	return get_field<bq25186_fields::chg_status_int_mask>();
 }
 bool bq25186::set_chg_status_int_mask(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x06, BQ25186_I2C_BITMASK_2, value);
+	return set_field<bq25186_fields::chg_status_int_mask>(value);
 }
 uint8_t bq25186::get_ilim_int_mask() {
-	return read_bitmasked_value_from_register_(0x06,BQ25186_I2C_BITMASK_1);
+	return get_field<bq25186_fields::ilim_int_mask>();
 }
 bool bq25186::set_ilim_int_mask(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x06, BQ25186_I2C_BITMASK_1, value);
+	return set_field<bq25186_fields::ilim_int_mask>(value);
 }
 uint8_t bq25186::get_vindpm_int_mask() {
-	return read_bitmasked_value_from_register_(0x06,BQ25186_I2C_BITMASK_0);
+	return get_field<bq25186_fields::vindpm_int_mask>();
 }
 bool bq25186::set_vindpm_int_mask(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x06, BQ25186_I2C_BITMASK_0, value);
+	return set_field<bq25186_fields::vindpm_int_mask>(value);
 }
 //Register 0x07
-//ToDo
+uint8_t bq25186::get_ts_en() {
+	return get_field<bq25186_fields::ts_en>();
+}
+bool bq25186::set_ts_en(uint8_t value) {
+	return set_field<bq25186_fields::ts_en>(value);
+}
+uint8_t bq25186::get_vlowv_sel() {
+	return get_field<bq25186_fields::vlowv_sel>();
+}
+bool bq25186::set_vlowv_sel(uint8_t value) {
+	return set_field<bq25186_fields::vlowv_sel>(value);
+}
+uint8_t bq25186::get_vrch() {
+	return get_field<bq25186_fields::vrch>();
+}
+bool bq25186::set_vrch(uint8_t value) {
+	return set_field<bq25186_fields::vrch>(value);
+}
+uint8_t bq25186::get_timer_2x_en() {
+	return get_field<bq25186_fields::timer_2x_en>();
+}
+bool bq25186::set_timer_2x_en(uint8_t value) {
+	return set_field<bq25186_fields::timer_2x_en>(value);
+}
+uint8_t bq25186::get_safety_timer() {
+	return get_field<bq25186_fields::safety_timer>();
+}
+bool bq25186::set_safety_timer(uint8_t value) {
+	return set_field<bq25186_fields::safety_timer>(value);
+}
+uint8_t bq25186::get_watchdog_sel() {
+	return get_field<bq25186_fields::watchdog_sel>();
+}
+bool bq25186::set_watchdog_sel(uint8_t value) {
+	return set_field<bq25186_fields::watchdog_sel>(value);
+}
 
 //Register 0x08
 uint8_t bq25186::get_mr_lpress() {
-	return read_bitmasked_value_from_register_(0x08,BQ25186_I2C_BITMASK_7_6);
+	return get_field<bq25186_fields::mr_lpress>();
 }
 bool bq25186::set_mr_lpress(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x08, BQ25186_I2C_BITMASK_7_6, value);
+	return set_field<bq25186_fields::mr_lpress>(value);
+}
+uint8_t bq25186::get_mr_lpress_s() {
+	return to_units(bq25186_units::mr_lpress, get_field<bq25186_fields::mr_lpress>());
+}
+bool bq25186::set_mr_lpress_s(uint8_t seconds) {
+	return set_field<bq25186_fields::mr_lpress>(from_units(bq25186_units::mr_lpress, seconds));
 }
 uint8_t bq25186::get_mr_reset_vin() {
-	return read_bitmasked_value_from_register_(0x08,BQ25186_I2C_BITMASK_5);
+	return get_field<bq25186_fields::mr_reset_vin>();
 }
 bool bq25186::set_mr_reset_vin(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x08, BQ25186_I2C_BITMASK_5, value);
+	return set_field<bq25186_fields::mr_reset_vin>(value);
 }
 uint8_t bq25186::get_autowake() {
-	return read_bitmasked_value_from_register_(0x08,BQ25186_I2C_BITMASK_4_3);
+	return get_field<bq25186_fields::autowake>();
 }
 bool bq25186::set_autowake(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x08, BQ25186_I2C_BITMASK_4_3, value);
+	return set_field<bq25186_fields::autowake>(value);
+}
+uint16_t bq25186::get_autowake_ms() {
+	return to_units(bq25186_units::autowake, get_field<bq25186_fields::autowake>());
+}
+bool bq25186::set_autowake_ms(uint16_t milliseconds) {
+	return set_field<bq25186_fields::autowake>(from_units(bq25186_units::autowake, milliseconds));
 }
 uint8_t bq25186::get_ilim() {
-	return read_bitmasked_value_from_register_(0x08,BQ25186_I2C_BITMASK_4_3);
+	return get_field<bq25186_fields::ilim>();
 }
 bool bq25186::set_ilim(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x08, BQ25186_I2C_BITMASK_4_3, value);
+	return set_field<bq25186_fields::ilim>(value);
+}
+uint16_t bq25186::get_ilim_ma() {
+	return to_units(bq25186_units::ilim, get_field<bq25186_fields::ilim>());
+}
+bool bq25186::set_ilim_ma(uint16_t milliamps) {
+	return set_field<bq25186_fields::ilim>(from_units(bq25186_units::ilim, milliamps));
 }
 //Register 0x09
 uint8_t bq25186::get_reg_rst() {
-	return read_bitmasked_value_from_register_(0x09,BQ25186_I2C_BITMASK_7);
+	return get_field<bq25186_fields::reg_rst>();
 }
 bool bq25186::set_reg_rst(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x09, BQ25186_I2C_BITMASK_7, value);
+	return set_field<bq25186_fields::reg_rst>(value);
 }
 uint8_t bq25186::get_reset_ship() {
-	return read_bitmasked_value_from_register_(0x09,BQ25186_I2C_BITMASK_6_5);
+	return get_field<bq25186_fields::reset_ship>();
 }
 bool bq25186::set_reset_ship(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x09, BQ25186_I2C_BITMASK_6_5, value);
+	return set_field<bq25186_fields::reset_ship>(value);
 }
 uint8_t bq25186::get_lpress_action() {
-	return read_bitmasked_value_from_register_(0x09,BQ25186_I2C_BITMASK_4_3);
+	return get_field<bq25186_fields::lpress_action>();
 }
 bool bq25186::set_lpress_action(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x09, BQ25186_I2C_BITMASK_4_3, value);
+	return set_field<bq25186_fields::lpress_action>(value);
 }
 uint8_t bq25186::get_wake1_tmr() {
-	return read_bitmasked_value_from_register_(0x09,BQ25186_I2C_BITMASK_2);
+	return get_field<bq25186_fields::wake1_tmr>();
 }
 bool bq25186::set_wake1_tmr(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x09, BQ25186_I2C_BITMASK_2, value);
+	return set_field<bq25186_fields::wake1_tmr>(value);
 }
 uint8_t bq25186::get_wake2_tmr() {
-	return read_bitmasked_value_from_register_(0x09,BQ25186_I2C_BITMASK_1);
+	return get_field<bq25186_fields::wake2_tmr>();
 }
 bool bq25186::set_wake2_tmr(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x09, BQ25186_I2C_BITMASK_1, value);
+	return set_field<bq25186_fields::wake2_tmr>(value);
 }
 uint8_t bq25186::get_en_push() {
-	return read_bitmasked_value_from_register_(0x09,BQ25186_I2C_BITMASK_0);
+	return get_field<bq25186_fields::en_push>();
 }
 bool bq25186::set_en_push(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x09, BQ25186_I2C_BITMASK_0, value);
+	return set_field<bq25186_fields::en_push>(value);
 }
 
 //Register 0x0a
 uint8_t bq25186::get_sys_regulation_voltage() {
-	return read_bitmasked_value_from_register_(0x0a, 0b11100000);
+	return get_field<bq25186_fields::sys_regulation_voltage>();
 }
 bool bq25186::set_sys_regulation_voltage(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x0a, 0b11100000, value);
+	return set_field<bq25186_fields::sys_regulation_voltage>(value);
+}
+uint16_t bq25186::get_sys_regulation_voltage_mv() {
+	return to_units(bq25186_units::sys_regulation_voltage, get_field<bq25186_fields::sys_regulation_voltage>());
+}
+bool bq25186::set_sys_regulation_voltage_mv(uint16_t millivolts) {
+	return set_field<bq25186_fields::sys_regulation_voltage>(from_units(bq25186_units::sys_regulation_voltage, millivolts));
 }
 uint8_t bq25186::get_pg_pin_state() {
-	return read_bitmasked_value_from_register_(0x0a, 0b00010000);
+	return get_field<bq25186_fields::pg_pin_state>();
 }
 bool bq25186::set_pg_pin_state(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x0a, 0b00010000, value);
+	return set_field<bq25186_fields::pg_pin_state>(value);
 }
 uint8_t bq25186::get_sys_mode() {
-	return read_bitmasked_value_from_register_(0x0a, 0b00001100);
+	return get_field<bq25186_fields::sys_mode>();
 }
 bool bq25186::set_sys_mode(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x0a, 0b00001100, value);
+	return set_field<bq25186_fields::sys_mode>(value);
 }
 uint8_t bq25186::get_i2c_watchdog_mode() {
-	return read_bitmasked_value_from_register_(0x0a, 0b00000010);
+	return get_field<bq25186_fields::i2c_watchdog_mode>();
 }
 bool bq25186::set_i2c_watchdog_mode(uint8_t value) {
-	return write_bitmasked_value_to_register_(0x0a, 0b00000010, value);
+	return set_field<bq25186_fields::i2c_watchdog_mode>(value);
 }
 #endif
@@ -9,10 +9,61 @@
  
 #ifndef bq25186_h
 #define bq25186_h
-#include <Arduino.h>	//Include the Arduino library	
-#include "Wire.h"		//Include the I²C library
+#include "bq25186_bus.h"	//Include the I²C bus interface, which includes the Arduino and I²C libraries where available
+#include <string.h>
 
-#define BQ25186_INCLUDE_DEBUG_FUNCTIONS
+#if defined(ARDUINO)
+	#define BQ25186_INCLUDE_DEBUG_FUNCTIONS									//Debug output needs an Arduino Stream
+#endif
+//#define BQ25186_INCLUDE_STATISTICS									//Uncomment to count bus transactions, errors, timing and cache use, see get_stats()
+#if !defined BQ25186_INCLUDE_FLOAT_API && !defined BQ25186_NO_FLOAT_API
+	#define BQ25186_INCLUDE_FLOAT_API									//Comment out or build with -DBQ25186_NO_FLOAT_API for a build without floating point, the float functions only wrap the mV ones
+#endif
+//#define BQ25186_THREAD_SAFE												//Uncomment to protect each instance with a mutex and allow a worker task, needs FreeRTOS (ESP32) or std::thread (host builds)
+
+#if defined BQ25186_THREAD_SAFE
+	#include <atomic>
+	#if defined(ESP32)
+		#include "freertos/FreeRTOS.h"
+		#include "freertos/semphr.h"
+		#include "freertos/task.h"
+		typedef SemaphoreHandle_t bq25186_mutex_t;							//Must be a recursive mutex
+	#elif !defined(ARDUINO)
+		#include <mutex>
+		#include <thread>
+		#include <condition_variable>
+		typedef std::recursive_mutex *bq25186_mutex_t;
+	#else
+		#error "BQ25186_THREAD_SAFE needs FreeRTOS or std::thread"
+	#endif
+#endif
+
+#define BQ25186_LOG_NONE					0						//Log levels, set BQ25186_LOG_LEVEL to one of these below or with a build flag, a #define in a sketch is not seen by bq25186.cpp
+#define BQ25186_LOG_ERROR					1						//Failed reads and writes
+#define BQ25186_LOG_INFO					2						//Also begin() and commit()
+#define BQ25186_LOG_TRACE					3						//Also every register read, write and staged change
+#if !defined BQ25186_LOG_LEVEL
+	#define BQ25186_LOG_LEVEL BQ25186_LOG_NONE							//Change here or with -DBQ25186_LOG_LEVEL=n, logging compiles to nothing by default
+#endif
+#if !defined BQ25186_LOG_LENGTH
+	#define BQ25186_LOG_LENGTH 16											//Change here or with a build flag, how many log records are kept until drained, the oldest are overwritten
+#endif
+
+#if !defined BQ25186_MAX_SUBSCRIBERS
+	#define BQ25186_MAX_SUBSCRIBERS 4										//Change here or with a build flag, how many field change callbacks can be registered with subscribe()
+#endif
+#if !defined BQ25186_MAX_FAULT_LATCHES
+	#define BQ25186_MAX_FAULT_LATCHES 2										//Change here or with a build flag, how many private flag latches can be added with add_fault_latch()
+#endif
+#if !defined BQ25186_ASYNC_QUEUE_LENGTH
+	#define BQ25186_ASYNC_QUEUE_LENGTH 4									//Change here or with a build flag, how many asynchronous requests can be queued for update()
+#endif
+
+#if defined(ESP32) || defined(ESP8266)
+	#define BQ25186_ISR_ATTR IRAM_ATTR										//Interrupt handlers must be in RAM on these platforms
+#else
+	#define BQ25186_ISR_ATTR
+#endif
 
 //These defines are an attempt to make all the bitmask work legible without introducing tons of abstraction
 
@@ -33,6 +84,7 @@
 #define BQ25186_I2C_BITMASK_2				0b00000100
 #define BQ25186_I2C_BITMASK_21				0b00000110
 #define BQ25186_I2C_BITMASK_20				0b00000101
+#define BQ25186_I2C_BITMASK_2_0				0b00000111
 #define BQ25186_I2C_BITMASK_1				0b00000010
 #define BQ25186_I2C_BITMASK_1_0				0b00000011
 #define BQ25186_I2C_BITMASK_0				0b00000001
@@ -112,6 +164,36 @@
 #define BQ25186_BAT_OCP_FAULT_NOT_DETECTED	BQ25186_I2C_BITMASK_NONE
 #define BQ25186_BAT_OCP_FAULT_DETECTED		BQ25186_I2C_BITMASK_0
 
+//Asynchronous request states
+
+#define BQ25186_ASYNC_IDLE					0x00
+#define BQ25186_ASYNC_READ_ADDRESS			0x01
+#define BQ25186_ASYNC_READ_DATA				0x02
+#define BQ25186_ASYNC_WRITE					0x03
+
+//Log record events
+
+#define BQ25186_EVENT_BEGIN					0x00
+#define BQ25186_EVENT_READ					0x01
+#define BQ25186_EVENT_WRITE					0x02
+#define BQ25186_EVENT_STAGE					0x03
+#define BQ25186_EVENT_COMMIT				0x04
+#define BQ25186_EVENT_RESET					0x05
+
+//Latched flags from registers 0x01 and 0x02 as accumulated by take_faults(), these are bits in a uint16_t
+
+#define BQ25186_FLAG_TS_FAULT				0x0400
+#define BQ25186_FLAG_ILIM_ACTIVE			0x0200
+#define BQ25186_FLAG_VDPPM_ACTIVE			0x0100
+#define BQ25186_FLAG_VINDPM_ACTIVE			0x0080
+#define BQ25186_FLAG_THERMREG_ACTIVE		0x0040
+#define BQ25186_FLAG_VIN_OVP_FAULT			0x0020
+#define BQ25186_FLAG_BUVLO_FAULT			0x0010
+#define BQ25186_FLAG_BAT_OCP_FAULT			0x0008
+#define BQ25186_FLAG_SAFETY_TMR_FAULT		0x0004
+#define BQ25186_FLAG_WAKE1					0x0002
+#define BQ25186_FLAG_WAKE2					0x0001
+
 //Register 0x03
 #define BQ25186_PG_PIN_MODE_PG				BQ25186_I2C_BITMASK_NONE
 #define BQ25186_PG_PIN_MODE_GPO				BQ25186_I2C_BITMASK_7
@@ -167,8 +249,29 @@
 #define BQ25186_VINDPM_INT_ENABLED			BQ25186_I2C_BITMASK_NONE
 #define BQ25186_VINDPM_INT_DISABLED			BQ25186_I2C_BITMASK_0
 
-//Register 0x06
-//ToDo
+//Register 0x07
+
+#define BQ25186_TS_DISABLED					BQ25186_I2C_BITMASK_NONE
+#define BQ25186_TS_ENABLED					BQ25186_I2C_BITMASK_7
+
+#define BQ25186_VLOWV_3_0V					BQ25186_I2C_BITMASK_NONE
+#define BQ25186_VLOWV_2_8V					BQ25186_I2C_BITMASK_6
+
+#define BQ25186_VRCH_100MV					BQ25186_I2C_BITMASK_NONE
+#define BQ25186_VRCH_200MV					BQ25186_I2C_BITMASK_5
+
+#define BQ25186_TIMER_2X_DISABLED			BQ25186_I2C_BITMASK_NONE
+#define BQ25186_TIMER_2X_ENABLED			BQ25186_I2C_BITMASK_4
+
+#define BQ25186_SAFETY_TIMER_3H				BQ25186_I2C_BITMASK_NONE
+#define BQ25186_SAFETY_TIMER_6H				BQ25186_I2C_BITMASK_2
+#define BQ25186_SAFETY_TIMER_12H			BQ25186_I2C_BITMASK_3
+#define BQ25186_SAFETY_TIMER_DISABLED		BQ25186_I2C_BITMASK_3_2
+
+#define BQ25186_WATCHDOG_160S_DEFAULTS		BQ25186_I2C_BITMASK_NONE	//Registers return to default when the watchdog expires
+#define BQ25186_WATCHDOG_160S_HW_RESET		BQ25186_I2C_BITMASK_0		//The device does a hardware reset when the watchdog expires
+#define BQ25186_WATCHDOG_40S_DEFAULTS		BQ25186_I2C_BITMASK_1
+#define BQ25186_WATCHDOG_DISABLED			BQ25186_I2C_BITMASK_1_0
 
 //Register 0x08
 
@@ -191,7 +294,7 @@
 #define BQ25186_ILIM_300_MA					BQ25186_I2C_BITMASK_1_0
 #define BQ25186_ILIM_400_MA					BQ25186_I2C_BITMASK_2
 #define BQ25186_ILIM_500_MA					BQ25186_I2C_BITMASK_20
-#define BQ25186_ILIM_665_MA					BQ25186_I2C_BITMASK_2_1
+#define BQ25186_ILIM_665_MA					BQ25186_I2C_BITMASK_21
 #define BQ25186_ILIM_1050_MA				BQ25186_I2C_BITMASK_2_0
 
 //Register 0x09
@@ -240,12 +343,273 @@
 #define BQ25186_SYS_WATCHDOG_15S_ENABLE		BQ25186_I2C_BITMASK_1
 #define BQ25186_SYS_WATCHDOG_15S_DISABLE	BQ25186_I2C_BITMASK_NONE
 
+//Compile-time register field descriptors, each one names a register and the bits of it a value occupies. Values stay in place, like the defines above
+
+constexpr uint8_t bq25186_mask_shift_(uint8_t mask) {
+	return (mask & 0x01) ? 0 : 1 + bq25186_mask_shift_(mask >> 1);
+}
+
+template<uint8_t Register, uint8_t Mask> struct bq25186_field {
+	static_assert(Register < 0x0d, "BQ25186 field register out of range");
+	static_assert(Mask != 0, "BQ25186 field has no bits");
+	static constexpr uint8_t reg = Register;
+	static constexpr uint8_t mask = Mask;
+	static constexpr uint8_t shift = bq25186_mask_shift_(Mask);				//Position of the lowest bit
+	static constexpr bool valid(uint8_t value) {							//Does a value fit in the field
+		return (value & ~Mask) == 0;
+	}
+	static constexpr uint8_t extract(uint8_t registerValue) {				//The field from a whole register value
+		return registerValue & Mask;
+	}
+	static constexpr uint8_t to_code(uint8_t value) {						//In place value to a plain number, eg. BQ25186_ILIM_200_MA to 2
+		return (value & Mask) >> shift;
+	}
+	static constexpr uint8_t from_code(uint8_t code) {						//Plain number to an in place value
+		return uint8_t(code << shift) & Mask;
+	}
+};
+
+template<class... Fields> struct bq25186_register_layout {				//Used to static_assert that the fields of one register don't overlap
+	static constexpr uint8_t mask = 0;
+	static constexpr uint8_t reg = 0xff;
+	static constexpr bool valid = true;
+};
+template<class Field, class... Rest> struct bq25186_register_layout<Field, Rest...> {
+	static constexpr uint8_t mask = Field::mask | bq25186_register_layout<Rest...>::mask;
+	static constexpr uint8_t reg = Field::reg;
+	static constexpr bool valid = (Field::mask & bq25186_register_layout<Rest...>::mask) == 0 &&
+		(bq25186_register_layout<Rest...>::reg == 0xff || bq25186_register_layout<Rest...>::reg == Field::reg) &&
+		bq25186_register_layout<Rest...>::valid;
+};
+
+namespace bq25186_fields {
+	//Register 0x00
+	typedef bq25186_field<0x00, BQ25186_I2C_BITMASK_7> ts_open_stat;
+	typedef bq25186_field<0x00, BQ25186_I2C_BITMASK_6_5> chg_stat;
+	typedef bq25186_field<0x00, BQ25186_I2C_BITMASK_4> ilim_active_stat;
+	typedef bq25186_field<0x00, BQ25186_I2C_BITMASK_3> vdppm_active_stat;
+	typedef bq25186_field<0x00, BQ25186_I2C_BITMASK_2> vindpm_active_stat;
+	typedef bq25186_field<0x00, BQ25186_I2C_BITMASK_1> thermreg_active_stat;
+	typedef bq25186_field<0x00, BQ25186_I2C_BITMASK_0> vin_pgood_stat;
+	//Register 0x01
+	typedef bq25186_field<0x01, BQ25186_I2C_BITMASK_7> vin_ovp_stat;
+	typedef bq25186_field<0x01, BQ25186_I2C_BITMASK_6> buvlo_stat;
+	typedef bq25186_field<0x01, BQ25186_I2C_BITMASK_4_3> ts_stat;
+	typedef bq25186_field<0x01, BQ25186_I2C_BITMASK_2> safety_tmr_fault_flag;
+	typedef bq25186_field<0x01, BQ25186_I2C_BITMASK_1> wake1_flag;
+	typedef bq25186_field<0x01, BQ25186_I2C_BITMASK_0> wake2_flag;
+	//Register 0x02
+	typedef bq25186_field<0x02, BQ25186_I2C_BITMASK_7> ts_fault;
+	typedef bq25186_field<0x02, BQ25186_I2C_BITMASK_6> ilim_active_flag;
+	typedef bq25186_field<0x02, BQ25186_I2C_BITMASK_5> vdppm_active_flag;
+	typedef bq25186_field<0x02, BQ25186_I2C_BITMASK_4> vindpm_active_flag;
+	typedef bq25186_field<0x02, BQ25186_I2C_BITMASK_3> thermreg_active_flag;
+	typedef bq25186_field<0x02, BQ25186_I2C_BITMASK_2> vin_ovp_fault_flag;
+	typedef bq25186_field<0x02, BQ25186_I2C_BITMASK_1> buvlo_fault_flag;
+	typedef bq25186_field<0x02, BQ25186_I2C_BITMASK_0> bat_ocp_fault;
+	//Register 0x03
+	typedef bq25186_field<0x03, BQ25186_I2C_BITMASK_7> pg_pin_mode;
+	typedef bq25186_field<0x03, BQ25186_I2C_BITMASK_6_0> vbatreg;
+	//Register 0x04
+	typedef bq25186_field<0x04, BQ25186_I2C_BITMASK_7> chg_dis;
+	typedef bq25186_field<0x04, BQ25186_I2C_BITMASK_6_0> ichg;
+	//Register 0x05
+	typedef bq25186_field<0x05, BQ25186_I2C_BITMASK_7> en_fc_mode;
+	typedef bq25186_field<0x05, BQ25186_I2C_BITMASK_6> iprechg;
+	typedef bq25186_field<0x05, BQ25186_I2C_BITMASK_5_4> iterm;
+	typedef bq25186_field<0x05, BQ25186_I2C_BITMASK_3_2> vindpm;
+	typedef bq25186_field<0x05, BQ25186_I2C_BITMASK_1_0> therm_reg;
+	//Register 0x06
+	typedef bq25186_field<0x06, BQ25186_I2C_BITMASK_7_6> ibat_ocp;
+	typedef bq25186_field<0x06, BQ25186_I2C_BITMASK_5_3> buvlo;
+	typedef bq25186_field<0x06, BQ25186_I2C_BITMASK_2> chg_status_int_mask;
+	typedef bq25186_field<0x06, BQ25186_I2C_BITMASK_1> ilim_int_mask;
+	typedef bq25186_field<0x06, BQ25186_I2C_BITMASK_0> vindpm_int_mask;
+	//Register 0x07
+	typedef bq25186_field<0x07, BQ25186_I2C_BITMASK_7> ts_en;
+	typedef bq25186_field<0x07, BQ25186_I2C_BITMASK_6> vlowv_sel;
+	typedef bq25186_field<0x07, BQ25186_I2C_BITMASK_5> vrch;
+	typedef bq25186_field<0x07, BQ25186_I2C_BITMASK_4> timer_2x_en;
+	typedef bq25186_field<0x07, BQ25186_I2C_BITMASK_3_2> safety_timer;
+	typedef bq25186_field<0x07, BQ25186_I2C_BITMASK_1_0> watchdog_sel;
+	//Register 0x08
+	typedef bq25186_field<0x08, BQ25186_I2C_BITMASK_7_6> mr_lpress;
+	typedef bq25186_field<0x08, BQ25186_I2C_BITMASK_5> mr_reset_vin;
+	typedef bq25186_field<0x08, BQ25186_I2C_BITMASK_4_3> autowake;
+	typedef bq25186_field<0x08, BQ25186_I2C_BITMASK_2_0> ilim;
+	//Register 0x09
+	typedef bq25186_field<0x09, BQ25186_I2C_BITMASK_7> reg_rst;
+	typedef bq25186_field<0x09, BQ25186_I2C_BITMASK_6_5> reset_ship;
+	typedef bq25186_field<0x09, BQ25186_I2C_BITMASK_4_3> lpress_action;
+	typedef bq25186_field<0x09, BQ25186_I2C_BITMASK_2> wake1_tmr;
+	typedef bq25186_field<0x09, BQ25186_I2C_BITMASK_1> wake2_tmr;
+	typedef bq25186_field<0x09, BQ25186_I2C_BITMASK_0> en_push;
+	//Register 0x0a
+	typedef bq25186_field<0x0a, BQ25186_I2C_BITMASK_7_5> sys_regulation_voltage;
+	typedef bq25186_field<0x0a, BQ25186_I2C_BITMASK_4> pg_pin_state;
+	typedef bq25186_field<0x0a, BQ25186_I2C_BITMASK_3_2> sys_mode;
+	typedef bq25186_field<0x0a, BQ25186_I2C_BITMASK_1> i2c_watchdog_mode;
+}
+
+#if defined(ARDUINO)
+typedef __FlashStringHelper bq25186_text;								//Display strings are kept in flash, Serial.print() takes them directly
+#else
+typedef char bq25186_text;
+#endif
+
+struct bq25186_field_units {											//Physical units and display strings of an enumerated field, both indexed by code and kept in flash
+	uint8_t mask;
+	uint8_t shift;
+	uint8_t codes;															//Number of codes, ie. entries in each table
+	const uint16_t *units;													//0 where a setting isn't a fixed value, eg. VINDPM disabled
+	const char *text;														//Fixed width strings, text_width apart
+	uint8_t text_width;
+};
+
+namespace bq25186_units {												//Use with bq25186::to_units(), from_units() and to_text()
+	extern const bq25186_field_units ilim;									//mA
+	extern const bq25186_field_units ibat_ocp;								//mA
+	extern const bq25186_field_units buvlo;									//mV
+	extern const bq25186_field_units sys_regulation_voltage;				//mV, 0 for battery tracking and pass through
+	extern const bq25186_field_units vindpm;								//mV, 0 for VBAT+300mV and disabled
+	extern const bq25186_field_units iterm;									//Percent of ICHG, 0 for disabled
+	extern const bq25186_field_units autowake;								//ms
+	extern const bq25186_field_units mr_lpress;								//s
+}
+
+struct bq25186_status {												//Decoded copy of the status registers 0x00-0x02, filled by read_status()
+	bool ts_open;
+	uint8_t chg_stat;														//BQ25186_ENABLED_BUT_NOT_CHARGING, BQ25186_CC_CHARGING, BQ25186_CV_CHARGING or BQ25186_CHARGING_DONE_OR_DISABLED
+	bool ilim_active;
+	bool vdppm_active;
+	bool vindpm_active;
+	bool thermreg_active;
+	bool vin_pgood;
+	bool vin_ovp;
+	bool buvlo;
+	uint8_t ts_stat;														//BQ25186_TS_NORMAL, BQ25186_TS_TOO_HOT_OR_COLD, BQ25186_TS_COOL or BQ25186_TS_WARM
+	bool safety_tmr_fault;
+	bool wake1;
+	bool wake2;
+	bool ts_fault;
+	bool ilim_active_flag;
+	bool vdppm_active_flag;
+	bool vindpm_active_flag;
+	bool thermreg_active_flag;
+	bool vin_ovp_fault;
+	bool buvlo_fault;
+	bool bat_ocp_fault;
+};
+
+struct bq25186_config {												//Decoded copy of the configuration registers 0x03-0x0C, filled by read_config()
+	uint8_t pg_pin_mode;
+	uint16_t vbatreg_mv;
+	#if defined BQ25186_INCLUDE_FLOAT_API
+	float vbatreg;															//Volts
+	#endif
+	uint8_t chg_dis;
+	uint16_t ichg;															//mA
+	uint8_t en_fc_mode;
+	uint8_t iprechg;
+	uint8_t iterm;
+	uint8_t vindpm;
+	uint8_t therm_reg;
+	uint8_t ibat_ocp;
+	uint16_t buvlo_mv;
+	#if defined BQ25186_INCLUDE_FLOAT_API
+	float buvlo;															//Volts
+	#endif
+	uint8_t chg_status_int_mask;
+	uint8_t ilim_int_mask;
+	uint8_t vindpm_int_mask;
+	uint8_t mr_lpress;
+	uint8_t mr_reset_vin;
+	uint8_t autowake;
+	uint8_t ilim;
+	uint8_t lpress_action;
+	uint8_t wake1_tmr;
+	uint8_t wake2_tmr;
+	uint8_t en_push;
+	uint8_t sys_regulation_voltage;
+	uint8_t pg_pin_state;
+	uint8_t sys_mode;
+	uint8_t i2c_watchdog_mode;
+};
+
+#define BQ25186_CONFIG_IMAGE_VERSION		0x01					//Changes if the layout of bq25186_config_image does
+
+struct bq25186_config_image {										//Raw configuration registers 0x03-0x0C to save in EEPROM, NVS or a file, filled by get_config_image()
+	uint8_t version;														//BQ25186_CONFIG_IMAGE_VERSION
+	uint8_t registers[0x0a];												//Registers 0x03-0x0C, without the reset and ship mode bits of 0x09
+	uint8_t crc;															//CRC-8 of the version and registers
+};
+
+struct bq25186_async_request {										//A queued asynchronous read or write
+	uint8_t type;															//BQ25186_ASYNC_READ_ADDRESS for a read, BQ25186_ASYNC_WRITE for a write
+	uint8_t start;
+	uint8_t length;
+	uint8_t mask;
+	uint8_t value;
+	void (*callback)(bool);
+};
+
+struct bq25186_subscriber {											//A field change callback registered with subscribe()
+	uint8_t reg;
+	uint8_t mask;
+	void (*callback)(uint8_t, uint8_t);										//Passed the previous and new value of the field, in place like the BQ25186_* values
+};
+
+#if BQ25186_LOG_LEVEL > BQ25186_LOG_NONE
+struct bq25186_log_record {												//One logged event, kept small so logging is cheap enough for the I²C path
+	uint32_t timestamp;														//micros() when the event happened
+	uint8_t event;															//BQ25186_EVENT_*
+	uint8_t reg;															//Register, or first register of a burst
+	uint8_t mask;															//Bits written, or the number of registers for a burst read/commit
+	uint8_t old_value;
+	uint8_t new_value;
+	uint8_t error;															//BQ25186_BUS_* error code, BQ25186_BUS_OK on success
+};
+#endif
+
+#if defined BQ25186_INCLUDE_STATISTICS
+struct bq25186_stats {													//Bus and cache statistics, filled by get_stats()
+	uint32_t transactions;													//Calls to the bus, a register read is one write-then-read
+	uint32_t bytes_read;
+	uint32_t bytes_written;
+	uint32_t errors[BQ25186_BUS_TIMEOUT + 1];								//Failed transactions indexed by BQ25186_BUS_* error code
+	uint32_t cache_hits[0x0d];												//Per register, uses of the cached value without a read
+	uint32_t cache_misses[0x0d];											//Per register, uses that needed a read
+	uint32_t min_transfer_us;
+	uint32_t max_transfer_us;
+	uint32_t average_transfer_us;
+	uint32_t total_transfer_us;
+	uint32_t keepalives;													//Transactions made only to feed the watchdog
+	uint32_t retries;														//Transfers and writes tried again after failing
+	uint32_t recoveries;													//Successful bus recoveries
+	uint32_t verify_failures;												//Writes that read back differently
+	uint32_t over_budget;													//Transfers or retries skipped to stay within the latency budget
+};
+#endif
+
+#if defined BQ25186_THREAD_SAFE
+class bq25186_lock {													//Holds a bq25186_mutex_t for the life of the object
+	public:
+		bq25186_lock(bq25186_mutex_t mutex);
+		~bq25186_lock();
+	private:
+		bq25186_mutex_t mutex_;
+};
+#endif
+
 class bq25186 {
 
 	public:
 		bq25186();															//Constructor function
 		~bq25186();															//Destructor function
+		#if defined(ARDUINO)
 		bool begin(TwoWire &i2cPort = Wire);								//Start the bq25186
+		#endif
+		bool begin(bq25186_bus &bus);										//Start the bq25186 on any other bus, eg. bq25186_simulator
 		//Readable flags/status, see device datasheet for explanation of the values
 		//Register 0x00
 		uint8_t ts_open_stat();
@@ -274,13 +638,17 @@ class bq25186 {
 		//Register 0x03
 		uint8_t get_pg_pin_mode();
 		bool set_pg_pin_mode(uint8_t value);
+		uint16_t get_vbatreg_mv();											//0 on an I²C error
+		bool set_vbatreg_mv(uint16_t millivolts);							//3500-4650mV, rounded to the nearest 10mV
+		#if defined BQ25186_INCLUDE_FLOAT_API
 		float get_vbatreg();
 		bool set_vbatreg(float voltage);
+		#endif
 		//Register 0x04
 		uint8_t get_chg_dis();
 		bool set_chg_dis(uint8_t value);
-		uint16_t get_ichg();
-		bool set_ichg(uint16_t value);
+		uint16_t get_ichg();												//mA, 0 on an I²C error
+		bool set_ichg(uint16_t value);										//5-1000mA, 1mA steps from 5mA to 36mA then 10mA steps from 50mA, rounded to the nearest
 		//Register 0x05
 		uint8_t get_en_fc_mode();
 		bool set_en_fc_mode(uint8_t value);
@@ -288,15 +656,25 @@ class bq25186 {
 		bool set_iprechg(uint8_t value);
 		uint8_t get_iterm();
 		bool set_iterm(uint8_t value);
+		uint8_t get_iterm_percent();										//Percent of ICHG, 0 if disabled or on an I²C error
+		bool set_iterm_percent(uint8_t percent);							//The nearest of 5, 10 and 20%, 0 disables termination
 		uint8_t get_vindpm();
 		bool set_vindpm(uint8_t value);
+		uint16_t get_vindpm_mv();											//0 on an I²C error or if it isn't a fixed voltage, ie. VBAT+300mV or disabled
+		bool set_vindpm_mv(uint16_t millivolts);							//The nearest fixed voltage, 4500mV or 4700mV
 		uint8_t get_therm_reg();
 		bool set_therm_reg(uint8_t value);
 		//Register 0x06
 		uint8_t get_ibat_ocp();
 		bool set_ibat_ocp(uint8_t value);
+		uint16_t get_ibat_ocp_ma();											//0 on an I²C error
+		bool set_ibat_ocp_ma(uint16_t milliamps);							//The nearest of 500, 1000, 1500 and 3000mA
+		uint16_t get_buvlo_mv();											//0 on an I²C error
+		bool set_buvlo_mv(uint16_t millivolts);								//The nearest of 2000-3000mV in 200mV steps
+		#if defined BQ25186_INCLUDE_FLOAT_API
 		float get_buvlo();
 		bool set_buvlo(float value);
+		#endif
 		uint8_t get_chg_status_int_mask();
 		bool set_chg_status_int_mask(uint8_t value);
 		uint8_t get_ilim_int_mask();
@@ -304,15 +682,33 @@ class bq25186 {
 		uint8_t get_vindpm_int_mask();
 		bool set_vindpm_int_mask(uint8_t value);
 		//Register 0x07
+		uint8_t get_ts_en();
+		bool set_ts_en(uint8_t value);
+		uint8_t get_vlowv_sel();
+		bool set_vlowv_sel(uint8_t value);
+		uint8_t get_vrch();
+		bool set_vrch(uint8_t value);
+		uint8_t get_timer_2x_en();
+		bool set_timer_2x_en(uint8_t value);
+		uint8_t get_safety_timer();
+		bool set_safety_timer(uint8_t value);
+		uint8_t get_watchdog_sel();
+		bool set_watchdog_sel(uint8_t value);
 		//Register 0x08
 		uint8_t get_mr_lpress();
 		bool set_mr_lpress(uint8_t value);							//Available values are 5/10/15/20s
+		uint8_t get_mr_lpress_s();											//0 on an I²C error
+		bool set_mr_lpress_s(uint8_t seconds);								//The nearest of 5, 10, 15 and 20s
 		uint8_t get_mr_reset_vin();
 		bool set_mr_reset_vin(uint8_t value);
 		uint8_t get_autowake();
 		bool set_autowake(uint8_t value);
+		uint16_t get_autowake_ms();											//0 on an I²C error
+		bool set_autowake_ms(uint16_t milliseconds);						//The nearest of 500, 1000, 2000 and 4000ms
 		uint8_t get_ilim();
 		bool set_ilim(uint8_t value);
+		uint16_t get_ilim_ma();												//0 on an I²C error
+		bool set_ilim_ma(uint16_t milliamps);								//The nearest of 50, 100, 200, 300, 400, 500, 665 and 1050mA
 		//Register 0x09
 		uint8_t get_reg_rst();
 		bool set_reg_rst(uint8_t value);
@@ -329,12 +725,123 @@ class bq25186 {
 		//Register 0xa0
 		uint8_t get_sys_regulation_voltage();
 		bool set_sys_regulation_voltage(uint8_t value);
+		uint16_t get_sys_regulation_voltage_mv();							//0 on an I²C error or if it isn't a fixed voltage, ie. battery tracking or pass through
+		bool set_sys_regulation_voltage_mv(uint16_t millivolts);			//The nearest of 4400-4900mV in 100mV steps
 		uint8_t get_pg_pin_state();
 		bool set_pg_pin_state(uint8_t value);
 		uint8_t get_sys_mode();
 		bool set_sys_mode(uint8_t value);
 		uint8_t get_i2c_watchdog_mode();
 		bool set_i2c_watchdog_mode(uint8_t value);
+		//Typed access to any field in bq25186_fields, eg. get_field<bq25186_fields::ilim>()
+		template<class Field> uint8_t get_field() {
+			return read_bitmasked_value_from_register_(Field::reg, Field::mask);
+		}
+		template<class Field> bool set_field(uint8_t value) {				//Returns false if the value doesn't fit the field
+			return Field::valid(value) && write_bitmasked_value_to_register_(Field::reg, Field::mask, value);
+		}
+		template<class Field, uint8_t Value> bool set_field() {				//Value is checked at compile time, eg. set_field<bq25186_fields::ilim, BQ25186_ILIM_500_MA>()
+			static_assert(Field::valid(Value), "Value does not fit in the BQ25186 field");
+			return write_bitmasked_value_to_register_(Field::reg, Field::mask, Value);
+		}
+		bool get_registers(uint8_t start, uint8_t length, uint8_t *values);	//Copy raw register values, refreshing them from the device if the cache needs it
+		//Conversion of enumerated fields, eg. to_text(bq25186_units::ilim, config.ilim)
+		static uint16_t to_units(const bq25186_field_units &field,			//In place value to units, 0 if it isn't a fixed value or is BQ25186_I2C_ERROR
+			uint8_t value);
+		static uint8_t from_units(const bq25186_field_units &field,			//The in place value nearest to some units, settings without a fixed value are never chosen
+			uint16_t units);
+		static const bq25186_text *to_text(const bq25186_field_units &field,	//In place value to a display string, "unknown" for BQ25186_I2C_ERROR
+			uint8_t value);
+		//Snapshots, decode a set of registers read in one transaction
+		bool read_status(bq25186_status &status);							//Fill in all the status values, returns false on an I²C error
+		bool read_config(bq25186_config &config);							//Fill in all the configuration values, returns false on an I²C error
+		//Configuration images
+		bool get_config_image(bq25186_config_image &image);					//Copy the configuration registers into an image, returns false on an I²C error
+		bool apply_config_image(const bq25186_config_image &image);			//Write only the registers that differ from the image in one burst, false if the image is invalid or on an I²C error
+		static bool config_image_valid(const bq25186_config_image &image);	//Check the version and CRC, eg. after loading from EEPROM
+		//Reset detection, a sentinel configuration register is read with the status and the image is written back if it has reverted
+		bool set_reset_detection(const bq25186_config_image &image,			//The configuration to restore, false if the image or sentinel is invalid
+			uint8_t sentinel = 0x04);
+		void disable_reset_detection();
+		void set_reset_callback(void (*callback)(bool));					//Called when a reset is found, with true once the image is written back
+		uint16_t get_reset_count();											//Resets found since begin()
+		#if !defined(ARDUINO)
+		static bool save_config_image(const char *path,						//Host builds, write an image to a file
+			const bq25186_config_image &image);
+		static bool load_config_image(const char *path,						//Host builds, read an image from a file, false if it is missing or invalid
+			bq25186_config_image &image);
+		#endif
+		//Change notification, subscribers are called when a read finds a field has changed
+		bool subscribe(uint8_t index, uint8_t mask,							//Call back when any of these bits in the register change, false if the table is full
+			void (*callback)(uint8_t, uint8_t));
+		template<class Field> bool subscribe(void (*callback)(uint8_t, uint8_t)) {	//eg. subscribe<bq25186_fields::chg_stat>(chargeStateChanged)
+			return subscribe(Field::reg, Field::mask, callback);
+		}
+		void unsubscribe(void (*callback)(uint8_t, uint8_t));				//Remove every subscription using this callback
+		//Latched flags, accumulated from every read of registers 0x01 and 0x02 so none are lost to clear-on-read
+		uint16_t pending_faults();											//The BQ25186_FLAG_* values seen since the last take_faults()
+		uint16_t take_faults();												//Return and clear the BQ25186_FLAG_* values seen since the last call
+		uint16_t get_fault_count(uint16_t flag);							//How many times a single BQ25186_FLAG_* value has been seen
+		void reset_fault_counts();
+		bool add_fault_latch(uint16_t &latch);								//Also fold every flag read into this latch, for code that must see flags whatever take_faults() callers do
+		void remove_fault_latch(uint16_t &latch);
+		uint16_t take_fault_latch(uint16_t &latch);							//Return and clear a latch added with add_fault_latch()
+		#if defined BQ25186_INCLUDE_STATISTICS
+		//Statistics
+		void get_stats(bq25186_stats &stats);								//Copy the bus and cache statistics
+		void reset_stats();
+		#endif
+		//Register caching
+		void set_status_cache_ttl(uint32_t milliseconds);					//How long cached status registers 0x00-0x02 are used before re-reading, 0 means until invalidated
+		void set_config_cache_ttl(uint32_t milliseconds);					//How long cached configuration registers 0x03-0x0C are used before re-reading, 0 (default) means until invalidated
+		void invalidate_cache();											//Force every register to be re-read on next use
+		void invalidate_status_cache();										//Force the status registers to be re-read on next use
+		//Batched configuration
+		void begin_config();												//Stage subsequent set_* calls in the cache instead of writing them immediately
+		bool commit();														//Write all staged changes as burst writes of contiguous registers, false if any failed
+		void abort_config();												//Discard any staged changes
+		//Asynchronous operation, each call to update() does at most one short I²C transfer
+		bool queue_read(uint8_t start, uint8_t length,						//Queue a refresh of the cached registers, callback is passed true on success
+			void (*callback)(bool) = nullptr);
+		bool queue_write(uint8_t index, uint8_t mask, uint8_t value,		//Queue a bitmasked write to a configuration register
+			void (*callback)(bool) = nullptr);
+		bool update();														//Advance queued requests by one bus phase, returns true while more work is queued
+		bool async_busy();													//True until every queued request has completed
+		#if defined BQ25186_THREAD_SAFE
+		//Multi-task access
+		void set_bus_mutex(bq25186_mutex_t mutex);							//Share a recursive mutex with other drivers on the same I²C bus, call before begin()
+		bq25186_mutex_t get_bus_mutex();									//The mutex in use, so other drivers can share it
+		bool start_worker(uint32_t stackSize = 4096, uint8_t priority = 1);	//Start a task that owns the bus and runs queued requests, no need to call update()
+		void stop_worker();													//Returns once the task has exited, don't call it from a callback the task runs
+		#endif
+		//I²C watchdog keepalive, only talks to the device when nothing else has recently enough
+		bool keepalive();													//Call regularly, feeds the watchdog if it is due, false on an I²C error
+		uint32_t next_keepalive();											//Milliseconds until keepalive() needs the bus, 0xffffffff if the watchdog is disabled
+		uint32_t get_watchdog_period();										//Milliseconds, from the cached registers 0x07 and 0x0a, 0 if disabled
+		void set_keepalive_margin(uint32_t milliseconds);					//How long before the watchdog expires keepalive() feeds it, default 2000ms
+		//Error recovery
+		void set_retries(uint8_t retries,									//Try failed transfers again, waiting 'backoffMicroseconds' before the first retry and doubling it each time
+			uint16_t backoffMicroseconds = 100);
+		void set_write_verify(bool verify);									//Read back synchronous writes and write again if they didn't take, default off
+		void set_latency_budget(uint32_t microseconds);						//Upper bound on the time any one call spends on the bus, 0 (default) means no limit
+		uint8_t get_last_error();											//BQ25186_BUS_* code of the most recent transfer
+		//Interrupt driven operation
+		#if defined(ARDUINO)
+		bool enable_interrupt(uint8_t pin);									//Use the INT pin to trigger status reads in service(), only one charger per sketch can do this
+		void disable_interrupt();
+		#endif
+		bool service();														//Call regularly, reads the status registers once if the INT pin fired and runs any callbacks, otherwise calls keepalive()
+		void set_charge_state_callback(void (*callback)(uint8_t));			//Called with the new chg_stat() value when it changes
+		void set_power_good_lost_callback(void (*callback)());				//Called when vin_pgood_stat() goes from good to not good
+		void set_fault_callback(void (*callback)(uint8_t));					//Called with the value of register 0x02 when any fault flag is set
+		#if BQ25186_LOG_LEVEL > BQ25186_LOG_NONE
+		//Deferred logging, records are made on the I²C path and only formatted when drained
+		bool take_log_record(bq25186_log_record &record);					//Remove the oldest record, false if there are none
+		uint16_t log_dropped();												//Records overwritten before they were taken since the last call
+		#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
+		void drain_log(Stream &stream);										//Print and remove every record, call this outside timing critical code
+		#endif
+		#endif
 		#if defined BQ25186_INCLUDE_DEBUG_FUNCTIONS
 		void debug(Stream &);												//Start debugging on a stream
 		void print_registers();												//Print all the registers to the debug Stream
@@ -348,22 +855,139 @@ class bq25186 {
 		void printBinary(uint8_t value);									//Even if we had printf we need these two!
 		void printBinaryLn(uint8_t value);
 		#endif
-		TwoWire *i2cPort_ = nullptr;										//Pointer to I²C instance used by library
+		bq25186_bus *bus_ = nullptr;										//Pointer to I²C bus used by library
+		#if defined(ARDUINO)
+		bq25186_twowire_bus wire_bus_;										//Adapter used when begin() is passed a TwoWire instance
+		#endif
 		const uint8_t bq25186_i2c_address_ = 0x6a;							//This can't be changed
 		static const uint8_t bq25186_number_of_registers_ = 0x0d;
+		static const uint8_t bq25186_number_of_status_registers_ = 0x03;	//Registers 0x00-0x02 are flags/status, the rest configuration
 		bool bq25186_communicating_ok_ = false;
 		uint8_t registers[bq25186_number_of_registers_];					//Storage for the BQ2518 registers
-		uint32_t register_refresh_timer_ = 0;								//Rate limit register reads
-		uint32_t register_refresh_rate_limit_ = 1e3;						//Rate limit defaults to once every 1000ms
+		static const uint16_t bq25186_status_registers_mask_ = 0x0007;		//Cache bits for the status registers
+		uint16_t registers_fresh_ = 0;										//One bit per register, set when the cached copy can be trusted
+		uint32_t status_refresh_timer_ = 0;									//When the status registers were last read
+		uint32_t status_cache_ttl_ = 1e3;									//Status registers are re-read at most once every 1000ms by default
+		uint32_t config_refresh_timer_ = 0;									//When the configuration registers were last marked stale
+		uint32_t config_cache_ttl_ = 0;										//Configuration registers are write-through and trusted after begin() by default
+		bool config_transaction_ = false;									//Set between begin_config() and commit()
+		uint16_t registers_dirty_ = 0;										//One bit per register staged but not yet written
 		
 		bool read_registers_(uint8_t start = 0x00, uint8_t length = 0x0d,	//Read registers, normally automatic before any other status command
 			bool stop = true);
+		bool auto_refresh_registers_(uint8_t start, uint8_t length);		//Automatic refresh of a range of registers, only reading those not already fresh
 		uint8_t read_bitmasked_value_from_register_(uint8_t index,			//Read a bitmasked value from a register
 			uint8_t mask);
 		bool write_bitmasked_value_to_register_(uint8_t index, uint8_t mask,//Write a bitmasked value to a register
 			uint8_t value);
 		bool write_register_(uint8_t register, uint8_t value,				//Write a specific value to a specific register
 			bool stop = true);
+		bool write_registers_(uint8_t start, const uint8_t *values,			//Write consecutive registers in one auto-increment burst
+			uint8_t length, bool stop = true);
+		#if defined BQ25186_THREAD_SAFE
+		bq25186_mutex_t bus_mutex_;											//Held for every access to the cache or the bus
+		std::atomic<bool> worker_running_{false};
+		#if defined(ESP32)
+		SemaphoreHandle_t own_mutex_ = nullptr;								//Created by the constructor, deleted if replaced by set_bus_mutex()
+		TaskHandle_t worker_handle_ = nullptr;
+		SemaphoreHandle_t worker_stopped_ = nullptr;						//Given by the worker task as it exits
+		static void worker_task_(void *parameter);
+		#else
+		std::recursive_mutex own_mutex_;
+		std::thread worker_thread_;
+		std::mutex worker_wake_mutex_;
+		std::condition_variable worker_wake_;
+		bool worker_work_queued_ = false;
+		#endif
+		void wake_worker_();												//Tell the worker a request has been queued
+		#endif
+		bq25186_async_request async_queue_[BQ25186_ASYNC_QUEUE_LENGTH];		//Ring buffer of queued requests
+		uint8_t async_queue_head_ = 0;
+		uint8_t async_queue_length_ = 0;
+		uint8_t async_state_ = BQ25186_ASYNC_IDLE;							//Phase of the request at the head of the queue
+		bool queue_request_(uint8_t type, uint8_t start, uint8_t length,
+			uint8_t mask, uint8_t value, void (*callback)(bool));
+		#if defined BQ25186_INCLUDE_STATISTICS
+		bq25186_stats stats_ = {};
+		#endif
+		#if BQ25186_LOG_LEVEL > BQ25186_LOG_NONE
+		bq25186_log_record log_[BQ25186_LOG_LENGTH];						//Ring buffer of log records
+		uint8_t log_head_ = 0;
+		uint8_t log_length_ = 0;
+		uint16_t log_dropped_ = 0;
+		void log_event_(uint8_t event, uint8_t reg, uint8_t mask,			//Add a record, overwriting the oldest if full
+			uint8_t oldValue, uint8_t newValue, uint8_t error);
+		#endif
+		uint8_t last_bus_error_ = BQ25186_BUS_OK;							//Result of the most recent bus transfer
+		uint8_t retries_ = 0;
+		uint16_t retry_backoff_ = 100;										//Microseconds before the first retry
+		static const uint16_t bq25186_max_backoff_ = 0x3fff;				//The longest delayMicroseconds() is accurate for on AVR
+		bool verify_writes_ = false;
+		uint32_t latency_budget_ = 0;										//Microseconds, 0 for no limit
+		uint8_t call_depth_ = 0;											//Nesting of calls, the budget runs from the start of the outermost
+		uint32_t call_start_ = 0;
+		bool call_transferred_ = false;										//The first transfer of a call is always attempted
+		bool call_async_ = false;											//The outermost call is update(), which restores a reset as its own phase
+		uint32_t worst_transfer_us_ = 0;									//Longest transfer seen, to predict whether another fits the budget
+		uint32_t worst_recover_us_ = 1e3;									//Assumed until a recovery has been timed
+		class call_timer_ {													//Times the outermost call for the latency budget, part of BQ25186_LOCK()
+			public:
+				call_timer_(bq25186 *charger);
+				~call_timer_();
+			private:
+				bq25186 *charger_;
+		};
+		bool fits_budget_(uint32_t microseconds);							//Could this much more bus time be spent without passing the budget
+		uint8_t bus_attempt_(const uint8_t *writeData,						//One transfer without retries
+			uint8_t writeLength, uint8_t *readData, uint8_t readLength,
+			bool stop);
+		bool write_verified_(uint8_t start, const uint8_t *values,			//Read back a write and compare the bits that read back as written
+			uint8_t length);
+		uint32_t last_bus_activity_ = 0;									//When the device last acknowledged a transfer, which resets its watchdog
+		uint32_t keepalive_margin_ = 2e3;
+		uint8_t bus_transfer_(const uint8_t *writeData,						//Every bus access goes through here, returns a BQ25186_BUS_* error code
+			uint8_t writeLength, uint8_t *readData, uint8_t readLength,
+			bool stop = true);
+		void registers_received_(uint8_t start, const uint8_t *values,		//Update the cache after registers are read
+			uint8_t length);
+		bq25186_subscriber subscribers_[BQ25186_MAX_SUBSCRIBERS];
+		uint8_t subscriber_count_ = 0;
+		uint8_t subscribed_bits_[bq25186_number_of_registers_] = {};		//Per register, the bits any subscriber is interested in
+		uint16_t registers_known_ = 0;										//One bit per register read at least once since begin(), so there is something to compare with
+		void notify_subscribers_(uint8_t start, const uint8_t *previous,	//Call the subscribers to any changed fields
+			uint8_t length);
+		static const uint8_t bq25186_number_of_flags_ = 11;
+		uint16_t pending_faults_ = 0;										//Sticky copy of every flag read
+		uint16_t fault_counts_[bq25186_number_of_flags_] = {};				//Occurrences of each flag, indexed by bit
+		uint16_t *fault_latches_[BQ25186_MAX_FAULT_LATCHES] = {};			//Private copies of pending_faults_, each cleared only by its owner
+		uint8_t fault_latch_count_ = 0;
+		void accumulate_faults_(uint8_t start, uint8_t length);				//Fold the flag registers just read into pending_faults_
+		static uint16_t decode_vbatreg_(uint8_t value);						//Convert register values to mV or mA
+		static uint16_t decode_ichg_(uint8_t value);
+		bool reset_requested_(uint8_t shipRstValue);						//Does this value of register 0x09 reset the device registers
+		static uint8_t config_image_crc_(const bq25186_config_image &image);
+		static uint8_t crc8_(uint8_t crc, uint8_t value);					//CRC-8 with polynomial 0x07, as used by SMBus
+		bq25186_config_image reset_image_ = {};								//What to restore after a reset, follows every successful write while detection is on
+		uint8_t reset_sentinel_ = 0;										//0 when reset detection is off
+		bool reset_restore_pending_ = false;								//Set until the image has been written back
+		bool reset_restore_try_ = false;									//Set by each read of the sentinel while a restore is pending, so a failed restore waits for the next
+		uint16_t reset_count_ = 0;
+		void (*reset_callback_)(bool) = nullptr;
+		void restore_config_();												//Write the reset image back in one burst
+		void track_config_(uint8_t start, const uint8_t *values,			//Copy the configuration bits of registers written, or read for the first time, into the reset image
+			uint8_t length);
+		bool restore_due_();												//A restore is pending and nothing is staged or part way through
+		void reset_requested_cache_();										//After the library asked for a reset, so reset detection doesn't undo it
+		static bq25186 *interrupt_instance_;								//The instance the INT pin handler flags
+		static void BQ25186_ISR_ATTR interrupt_handler_();					//Minimal handler, only sets a flag for service()
+		int16_t interrupt_pin_ = -1;										//INT pin, -1 if not in use
+		volatile bool interrupt_pending_ = false;							//Set by the handler, cleared by service()
+		void (*charge_state_callback_)(uint8_t) = nullptr;
+		void (*power_good_lost_callback_)() = nullptr;
+		void (*fault_callback_)(uint8_t) = nullptr;
 		bool auto_refresh_all_registers_();									//Automatic refresh of all registers before any action
+		template<class Field> uint8_t cached_field_() {						//A field from the cache, without any refresh
+			return Field::extract(registers[Field::reg]);
+		}
 };
 #endif
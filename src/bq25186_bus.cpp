@@ -0,0 +1,96 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ */
+
+#ifndef bq25186_bus_cpp
+#define bq25186_bus_cpp
+#include "bq25186_bus.h"
+
+uint8_t bq25186_bus::write_read(uint8_t address, const uint8_t *writeData, uint8_t writeLength, uint8_t *readData, uint8_t readLength, bool stop) {
+	uint8_t i2cError = write(address, writeData, writeLength);		//Separate transactions unless a bus can do better
+	if(i2cError != BQ25186_BUS_OK) {
+		return i2cError;
+	}
+	return read(address, readData, readLength, stop);
+}
+#if defined(ARDUINO)
+bq25186_twowire_bus::bq25186_twowire_bus(TwoWire &wirePort) : wire_(&wirePort) {
+}
+void bq25186_twowire_bus::set_wire(TwoWire &wirePort) {
+	wire_ = &wirePort;
+}
+uint8_t bq25186_twowire_bus::write(uint8_t address, const uint8_t *data, uint8_t length, bool stop) {
+	wire_->beginTransmission(address);				//Start I2C transmission
+	wire_->write(data, length);						//Send the data
+	return wire_->endTransmission(stop);			//End the transmission, optionally with a stop
+}
+uint8_t bq25186_twowire_bus::read(uint8_t address, uint8_t *data, uint8_t length, bool stop) {
+	uint8_t bytesReceived = wire_->requestFrom(address, length, (uint8_t)stop);	//Request the bytes and optionally send a 'stop'
+	if(bytesReceived != length) {
+		while(wire_->available()) {					//Discard a partial read
+			wire_->read();
+		}
+		return BQ25186_BUS_OTHER_ERROR;
+	}
+	for(uint8_t index = 0; index < length; index++) {
+		data[index] = wire_->read();
+	}
+	return BQ25186_BUS_OK;
+}
+void bq25186_twowire_bus::set_recovery_pins(int8_t sdaPin, int8_t sclPin) {
+	sda_pin_ = sdaPin;
+	scl_pin_ = sclPin;
+}
+void bq25186_twowire_bus::set_clock(uint32_t frequency) {
+	clock_ = frequency;
+	wire_->setClock(frequency);
+}
+/*
+A device that was reset or lost clocks part way through sending a byte holds SDA low, waiting for the rest of the clocks. Up to nine clocks let it
+finish the byte and see a NACK, then a stop resets every device's I²C state machine. The pins are only ever pulled low or released, as both are open drain.
+*/
+bool bq25186_twowire_bus::recover() {
+	if(sda_pin_ < 0 || scl_pin_ < 0) {
+		return false;
+	}
+	uint32_t clock = clock_;
+	#if defined(ESP32)
+	if(clock == 0) {
+		clock = wire_->getClock();					//Only this core can say what the sketch set
+	}
+	#endif
+	#if !defined(ESP8266)
+	wire_->end();									//Release the pins from the I²C peripheral, the ESP8266 core has no end()
+	#endif
+	pinMode(sda_pin_, INPUT_PULLUP);
+	pinMode(scl_pin_, INPUT_PULLUP);
+	for(uint8_t clock = 0; clock < 9 && digitalRead(sda_pin_) == LOW; clock++) {
+		digitalWrite(scl_pin_, LOW);
+		pinMode(scl_pin_, OUTPUT);
+		delayMicroseconds(5);
+		pinMode(scl_pin_, INPUT_PULLUP);
+		delayMicroseconds(5);
+	}
+	bool released = digitalRead(sda_pin_) == HIGH;
+	digitalWrite(sda_pin_, LOW);					//Stop, SDA rising while SCL is high
+	pinMode(sda_pin_, OUTPUT);
+	delayMicroseconds(5);
+	pinMode(sda_pin_, INPUT_PULLUP);
+	delayMicroseconds(5);
+	#if defined(ESP32) || defined(ESP8266)
+	wire_->begin(sda_pin_, scl_pin_);
+	#else
+	wire_->begin();
+	#endif
+	if(clock != 0) {
+		wire_->setClock(clock);						//begin() goes back to the default 100kHz
+	}
+	return released;
+}
+#endif
+#endif
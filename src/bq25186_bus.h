@@ -0,0 +1,81 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	The I²C bus interface the library talks to the BQ25186 through, so it is not tied to Arduino TwoWire
+ *
+ */
+
+#ifndef bq25186_bus_h
+#define bq25186_bus_h
+#if defined(ARDUINO)
+#include <Arduino.h>	//Include the Arduino library
+#include "Wire.h"		//Include the I²C library
+#else
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+#include <thread>
+
+inline uint32_t millis() {		//Host builds have no Arduino core, so provide its timers
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t micros() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline void delayMicroseconds(uint32_t microseconds) {
+	std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+}
+#endif
+
+//Error codes, these are the same as the values returned by TwoWire endTransmission()
+
+#define BQ25186_BUS_OK						0x00
+#define BQ25186_BUS_DATA_TOO_LONG			0x01
+#define BQ25186_BUS_NACK_ADDRESS			0x02
+#define BQ25186_BUS_NACK_DATA				0x03
+#define BQ25186_BUS_OTHER_ERROR				0x04
+#define BQ25186_BUS_TIMEOUT					0x05
+
+//Not from the bus, these are returned by the library itself
+
+#define BQ25186_BUS_VERIFY_FAILED			0x06	//A write was acknowledged but reading it back found a different value
+#define BQ25186_BUS_OVER_BUDGET				0x07	//Not attempted as it could have taken the call past its latency budget
+
+class bq25186_bus {
+
+	public:
+		virtual ~bq25186_bus() {}
+		virtual uint8_t write(uint8_t address, const uint8_t *data,			//Write bytes to a device, returns a BQ25186_BUS_* error code
+			uint8_t length, bool stop = true) = 0;
+		virtual uint8_t read(uint8_t address, uint8_t *data,				//Read bytes from a device, returns a BQ25186_BUS_* error code
+			uint8_t length, bool stop = true) = 0;
+		virtual uint8_t write_read(uint8_t address, const uint8_t *writeData,	//Write then read, eg. a register address then its value. Override if the bus can do this in one transaction
+			uint8_t writeLength, uint8_t *readData, uint8_t readLength, bool stop = true);
+		virtual bool recover() {											//Try to free a bus held by a device, eg. by clocking SCL, true if it worked
+			return false;
+		}
+};
+
+#if defined(ARDUINO)
+class bq25186_twowire_bus : public bq25186_bus {							//Adapter for the Arduino TwoWire library
+
+	public:
+		bq25186_twowire_bus(TwoWire &wirePort = Wire);
+		void set_wire(TwoWire &wirePort);
+		uint8_t write(uint8_t address, const uint8_t *data, uint8_t length, bool stop = true) override;
+		uint8_t read(uint8_t address, uint8_t *data, uint8_t length, bool stop = true) override;
+		void set_recovery_pins(int8_t sdaPin, int8_t sclPin);				//The SDA and SCL pins, needed for recover()
+		void set_clock(uint32_t frequency);									//Calls setClock() and remembers the frequency so recover() can restore it
+		bool recover() override;											//Clock SCL until a device releases SDA, then send a stop and restart the TwoWire instance
+	private:
+		TwoWire *wire_;														//Pointer to I²C instance used
+		int8_t sda_pin_ = -1;
+		int8_t scl_pin_ = -1;
+		uint32_t clock_ = 0;												//Hz, 0 if set_clock() has not been used
+};
+#endif
+#endif
@@ -0,0 +1,93 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ */
+
+#ifndef bq25186_linux_i2c_cpp
+#define bq25186_linux_i2c_cpp
+#include "bq25186_linux_i2c.h"
+#if defined(__linux__) && !defined(ARDUINO)
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+
+bq25186_linux_i2c_bus::bq25186_linux_i2c_bus() {
+}
+bq25186_linux_i2c_bus::~bq25186_linux_i2c_bus() {
+	if(fd_ >= 0) {			//Not close(), a subclass's close_device_() can't be called from here
+		::close(fd_);
+	}
+}
+bool bq25186_linux_i2c_bus::open(const char *device) {
+	close();
+	fd_ = open_device_(device);
+	return fd_ >= 0;
+}
+bool bq25186_linux_i2c_bus::open(uint8_t busNumber) {
+	char device[16];
+	snprintf(device, sizeof(device), "/dev/i2c-%u", busNumber);
+	return open(device);
+}
+void bq25186_linux_i2c_bus::close() {
+	if(fd_ >= 0) {
+		close_device_(fd_);
+		fd_ = -1;
+	}
+}
+uint8_t bq25186_linux_i2c_bus::write(uint8_t address, const uint8_t *data, uint8_t length, bool stop) {
+	(void)stop;										//Every I2C_RDWR transfer ends with a stop
+	struct i2c_msg message = {address, 0, length, const_cast<uint8_t *>(data)};
+	return transfer_messages_(&message, 1);
+}
+uint8_t bq25186_linux_i2c_bus::read(uint8_t address, uint8_t *data, uint8_t length, bool stop) {
+	(void)stop;
+	struct i2c_msg message = {address, I2C_M_RD, length, data};
+	return transfer_messages_(&message, 1);
+}
+uint8_t bq25186_linux_i2c_bus::write_read(uint8_t address, const uint8_t *writeData, uint8_t writeLength, uint8_t *readData, uint8_t readLength, bool stop) {
+	(void)stop;
+	struct i2c_msg messages[2] = {
+		{address, 0, writeLength, const_cast<uint8_t *>(writeData)},	//Register pointer
+		{address, I2C_M_RD, readLength, readData}						//Repeated start then the data
+	};
+	return transfer_messages_(messages, 2);
+}
+uint8_t bq25186_linux_i2c_bus::transfer_messages_(struct i2c_msg *messages, uint32_t count) {
+	if(fd_ < 0) {
+		return BQ25186_BUS_OTHER_ERROR;
+	}
+	if(transfer_(fd_, messages, count) >= 0) {
+		return BQ25186_BUS_OK;
+	}
+	switch(errno) {
+		case ENXIO:
+		case EREMOTEIO:
+			return BQ25186_BUS_NACK_ADDRESS;
+		case ETIMEDOUT:
+			return BQ25186_BUS_TIMEOUT;
+		case EINVAL:
+		case EMSGSIZE:
+			return BQ25186_BUS_DATA_TOO_LONG;
+		default:
+			return BQ25186_BUS_OTHER_ERROR;
+	}
+}
+int bq25186_linux_i2c_bus::open_device_(const char *device) {
+	return ::open(device, O_RDWR);
+}
+void bq25186_linux_i2c_bus::close_device_(int fd) {
+	::close(fd);
+}
+int bq25186_linux_i2c_bus::transfer_(int fd, struct i2c_msg *messages, uint32_t count) {
+	struct i2c_rdwr_ioctl_data data = {messages, count};
+	return ioctl(fd, I2C_RDWR, &data);
+}
+#endif
+#endif
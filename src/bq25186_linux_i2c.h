@@ -0,0 +1,41 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Linux /dev/i2c-N bus for running the library on an embedded Linux board
+ *
+ */
+
+#ifndef bq25186_linux_i2c_h
+#define bq25186_linux_i2c_h
+#include "bq25186_bus.h"
+#if defined(__linux__) && !defined(ARDUINO)
+#include <linux/i2c.h>
+
+class bq25186_linux_i2c_bus : public bq25186_bus {
+
+	public:
+		bq25186_linux_i2c_bus();
+		virtual ~bq25186_linux_i2c_bus();									//Closes the file descriptor with the system close()
+		bool open(const char *device);										//Open a bus by device name, eg. "/dev/i2c-1". The file descriptor is kept open until close()
+		bool open(uint8_t busNumber);										//Open /dev/i2c-<busNumber>
+		void close();
+		uint8_t write(uint8_t address, const uint8_t *data, uint8_t length, bool stop = true) override;
+		uint8_t read(uint8_t address, uint8_t *data, uint8_t length, bool stop = true) override;
+		uint8_t write_read(uint8_t address, const uint8_t *writeData,		//One combined transaction with a repeated start
+			uint8_t writeLength, uint8_t *readData, uint8_t readLength, bool stop = true) override;
+	protected:
+		virtual int open_device_(const char *device);						//These wrap the system calls so a fake file descriptor layer can override them, a subclass that overrides close_device_() must call close() in its own destructor
+		virtual void close_device_(int fd);
+		virtual int transfer_(int fd, struct i2c_msg *messages,				//Returns the ioctl(I2C_RDWR) result, sets errno on failure
+			uint32_t count);
+	private:
+		int fd_ = -1;														//File descriptor of the open bus, -1 if closed
+		uint8_t transfer_messages_(struct i2c_msg *messages,				//Run the messages and convert any error to a BQ25186_BUS_* code
+			uint32_t count);
+};
+#endif
+#endif
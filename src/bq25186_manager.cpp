@@ -0,0 +1,97 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ */
+
+#ifndef bq25186_manager_cpp
+#define bq25186_manager_cpp
+#include "bq25186_manager.h"
+
+bq25186_manager::bq25186_manager() {
+}
+bool bq25186_manager::add(bq25186 &charger, uint8_t group) {
+	if(count_ >= BQ25186_MAX_CHARGERS) {
+		return false;
+	}
+	uint8_t index = count_;
+	while(index > 0 && groups_[index - 1] > group) {	//Insertion sort, keeps the order chargers in a group were added
+		chargers_[index] = chargers_[index - 1];
+		groups_[index] = groups_[index - 1];
+		index--;
+	}
+	chargers_[index] = &charger;
+	groups_[index] = group;
+	count_++;
+	next_ = 0;											//Start the round again
+	ok_ = 0;
+	return true;
+}
+bool bq25186_manager::set_budget(uint8_t transactions) {
+	if(transactions > 0 && transactions < bq25186_manager_min_budget_) {
+		return false;									//poll() would never read anything
+	}
+	budget_ = transactions;
+	return true;
+}
+uint8_t bq25186_manager::poll() {
+	if(count_ == 0) {
+		return 0;
+	}
+	uint8_t budget = budget_ > 0 ? budget_ : default_budget_();
+	uint8_t spent = 0;
+	uint8_t polled = 0;
+	bool first = true;
+	while(polled < count_) {
+		uint8_t cost = 1;
+		if(first || groups_[next_] != groups_[(next_ + count_ - 1) % count_]) {
+			cost++;										//Select the group, the first read of a poll always pays for it
+		}
+		if(spent + cost > budget) {
+			break;										//The rest wait for the next poll()
+		}
+		spent += cost;
+		first = false;
+		uint8_t status[3];
+		chargers_[next_]->invalidate_status_cache();	//One status burst per charger, whatever the cache time-to-live is
+		if(chargers_[next_]->get_registers(0x00, 3, status)) {
+			ok_ |= uint16_t(1) << next_;
+		} else {
+			ok_ &= ~(uint16_t(1) << next_);
+		}
+		polled++;
+		if(++next_ >= count_) {
+			next_ = 0;
+			cycles_++;
+		}
+	}
+	return polled;
+}
+uint8_t bq25186_manager::default_budget_() {
+	uint8_t budget = count_;
+	for(uint8_t index = 0; index < count_; index++) {
+		if(index == 0 || groups_[index] != groups_[index - 1]) {
+			budget++;
+		}
+	}
+	return budget;
+}
+uint8_t bq25186_manager::count() {
+	return count_;
+}
+bq25186 *bq25186_manager::charger(uint8_t index) {
+	return index < count_ ? chargers_[index] : nullptr;
+}
+uint8_t bq25186_manager::group(uint8_t index) {
+	return index < count_ ? groups_[index] : 0;
+}
+bool bq25186_manager::last_poll_ok(uint8_t index) {
+	return index < count_ && (ok_ & (uint16_t(1) << index));
+}
+uint32_t bq25186_manager::cycles() {
+	return cycles_;
+}
+#endif
@@ -0,0 +1,52 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Polls the status of several BQ25186 round-robin, within a fixed bus budget per call
+ *
+ */
+
+#ifndef bq25186_manager_h
+#define bq25186_manager_h
+#include "bq25186.h"
+
+#if !defined BQ25186_MAX_CHARGERS
+	#define BQ25186_MAX_CHARGERS			8								//Change here or with a build flag, a #define in a sketch is not seen by bq25186_manager.cpp
+#endif
+#if BQ25186_MAX_CHARGERS > 16
+	#error "BQ25186_MAX_CHARGERS can be at most 16"
+#endif
+
+class bq25186_manager {
+
+	public:
+		bq25186_manager();
+		bool add(bq25186 &charger, uint8_t group = 0);						//Chargers in the same group, eg. a multiplexer channel, are polled together. False if full
+		bool set_budget(uint8_t transactions);								//Upper bound on bus transactions per poll(), default one per charger plus one per group, false if too small to read a charger
+		uint8_t poll();														//Read the status of the next chargers in turn, returns how many were read
+		uint8_t count();													//Chargers added
+		bq25186 *charger(uint8_t index);									//In polling order, nullptr if out of range
+		uint8_t group(uint8_t index);
+		bool last_poll_ok(uint8_t index);									//Was the status read at the last attempt
+		uint32_t cycles();													//Times every charger has been polled
+	private:
+		/*
+		Chargers are kept sorted by group so one round visits each group once and, with a bq25186_mux, switches channel at most once per group. Each
+		status read is one transaction and each change of group is counted as one more for the channel select, whether or not the multiplexer already
+		had it selected, so the cost of a poll() doesn't depend on what ran before it. Only these planned transactions are counted, retries and recovery
+		from set_retries() and the configuration restore after a detected reset are not.
+		*/
+		bq25186 *chargers_[BQ25186_MAX_CHARGERS];
+		uint8_t groups_[BQ25186_MAX_CHARGERS];
+		uint8_t count_ = 0;
+		uint8_t next_ = 0;													//Cursor for the round-robin
+		uint8_t budget_ = 0;												//0 until set, then the default is worked out by poll()
+		static const uint8_t bq25186_manager_min_budget_ = 2;				//The first read of a poll() and its group select
+		uint16_t ok_ = 0;													//One bit per charger
+		uint32_t cycles_ = 0;
+		uint8_t default_budget_();
+};
+#endif
@@ -0,0 +1,83 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ */
+
+#ifndef bq25186_mux_cpp
+#define bq25186_mux_cpp
+#include "bq25186_mux.h"
+
+bq25186_mux::bq25186_mux(bq25186_bus &bus, uint8_t address) : bus_(&bus), address_(address) {
+}
+uint8_t bq25186_mux::select(uint8_t channel) {
+	if(channel > 7) {
+		return BQ25186_BUS_OTHER_ERROR;
+	}
+	if(channel == channel_) {
+		return BQ25186_BUS_OK;
+	}
+	return write_control_(1 << channel, channel);		//One bit per channel
+}
+uint8_t bq25186_mux::deselect() {
+	return write_control_(0x00, BQ25186_MUX_NO_CHANNEL);
+}
+uint8_t bq25186_mux::write_control_(uint8_t control, uint8_t channel) {
+	uint8_t i2cError = bus_->write(address_, &control, 1);
+	if(i2cError == BQ25186_BUS_OK) {
+		channel_ = channel;
+		switches_++;
+	} else {
+		channel_ = BQ25186_MUX_NO_CHANNEL;				//Unknown what is selected now, so select again next time
+	}
+	return i2cError;
+}
+uint8_t bq25186_mux::current_channel() {
+	return channel_;
+}
+void bq25186_mux::invalidate() {
+	channel_ = BQ25186_MUX_NO_CHANNEL;
+}
+uint32_t bq25186_mux::switches() {
+	return switches_;
+}
+bq25186_bus *bq25186_mux::bus() {
+	return bus_;
+}
+bq25186_mux_channel::bq25186_mux_channel(bq25186_mux &mux, uint8_t channel) : mux_(&mux), channel_(channel) {
+}
+uint8_t bq25186_mux_channel::write(uint8_t address, const uint8_t *data, uint8_t length, bool stop) {
+	uint8_t i2cError = mux_->select(channel_);
+	if(i2cError != BQ25186_BUS_OK) {
+		return i2cError;
+	}
+	return mux_->bus()->write(address, data, length, stop);
+}
+uint8_t bq25186_mux_channel::read(uint8_t address, uint8_t *data, uint8_t length, bool stop) {
+	uint8_t i2cError = mux_->select(channel_);
+	if(i2cError != BQ25186_BUS_OK) {
+		return i2cError;
+	}
+	return mux_->bus()->read(address, data, length, stop);
+}
+uint8_t bq25186_mux_channel::write_read(uint8_t address, const uint8_t *writeData, uint8_t writeLength, uint8_t *readData, uint8_t readLength, bool stop) {
+	uint8_t i2cError = mux_->select(channel_);
+	if(i2cError != BQ25186_BUS_OK) {
+		return i2cError;
+	}
+	return mux_->bus()->write_read(address, writeData, writeLength, readData, readLength, stop);	//Keeps the repeated start if the bus has one
+}
+bool bq25186_mux_channel::recover() {
+	mux_->invalidate();									//The multiplexer may have been reset too
+	return mux_->bus()->recover();
+}
+uint8_t bq25186_mux_channel::channel() {
+	return channel_;
+}
+bq25186_mux *bq25186_mux_channel::mux() {
+	return mux_;
+}
+#endif
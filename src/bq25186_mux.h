@@ -0,0 +1,51 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	TCA9548A style I²C multiplexer, so several BQ25186 (which all have the same address) can share one bus
+ *
+ */
+
+#ifndef bq25186_mux_h
+#define bq25186_mux_h
+#include "bq25186_bus.h"
+
+#define BQ25186_MUX_NO_CHANNEL				0xff
+
+class bq25186_mux {														//The multiplexer itself, shared by all its channels
+
+	public:
+		bq25186_mux(bq25186_bus &bus, uint8_t address = 0x70);
+		uint8_t select(uint8_t channel);									//Switch to a channel 0-7, only touching the bus if it isn't already selected. Returns a BQ25186_BUS_* error code
+		uint8_t deselect();													//Disconnect every channel
+		uint8_t current_channel();											//BQ25186_MUX_NO_CHANNEL if none or unknown
+		void invalidate();													//Forget the selected channel, if something else has written to the multiplexer
+		uint32_t switches();												//How many times the channel has been changed
+		bq25186_bus *bus();													//The bus the multiplexer is on
+	private:
+		bq25186_bus *bus_;
+		uint8_t address_;
+		uint8_t channel_ = BQ25186_MUX_NO_CHANNEL;							//Cached so a run of transactions on one channel costs one switch
+		uint32_t switches_ = 0;
+		uint8_t write_control_(uint8_t control, uint8_t channel);
+};
+
+class bq25186_mux_channel : public bq25186_bus {						//One channel of a multiplexer, pass this to begin()
+
+	public:
+		bq25186_mux_channel(bq25186_mux &mux, uint8_t channel);
+		uint8_t write(uint8_t address, const uint8_t *data, uint8_t length, bool stop = true) override;
+		uint8_t read(uint8_t address, uint8_t *data, uint8_t length, bool stop = true) override;
+		uint8_t write_read(uint8_t address, const uint8_t *writeData,
+			uint8_t writeLength, uint8_t *readData, uint8_t readLength, bool stop = true) override;
+		bool recover() override;											//Recovers the underlying bus, then selects the channel again on next use
+		uint8_t channel();
+		bq25186_mux *mux();
+	private:
+		bq25186_mux *mux_;
+		uint8_t channel_;
+};
+#endif
@@ -0,0 +1,27 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ */
+
+#ifndef bq25186_rate_limiter_cpp
+#define bq25186_rate_limiter_cpp
+#include "bq25186_rate_limiter.h"
+
+void bq25186_rate_limiter::set_min_interval(uint32_t milliseconds) {
+	min_interval_ = milliseconds;
+}
+void bq25186_rate_limiter::reset() {
+	recorded_ = false;
+}
+bool bq25186_rate_limiter::allowed() {
+	return recorded_ == false || millis() - timer_ >= min_interval_;
+}
+void bq25186_rate_limiter::record() {
+	timer_ = millis();
+	recorded_ = true;
+}
+#endif
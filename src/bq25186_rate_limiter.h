@@ -0,0 +1,28 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Minimum interval between writes, used by the solar tracker and thermal governor so they don't write the charger more often than asked
+ *
+ */
+
+#ifndef bq25186_rate_limiter_h
+#define bq25186_rate_limiter_h
+#include "bq25186.h"
+
+class bq25186_rate_limiter {
+
+	public:
+		void set_min_interval(uint32_t milliseconds);						//Least time between writes, 0 for no limit
+		void reset();														//Forget any previous write, so the next is allowed straight away
+		bool allowed();														//True if the interval has passed since the last write
+		void record();														//Call when a write is made
+	private:
+		uint32_t min_interval_ = 1e3;
+		uint32_t timer_ = 0;
+		bool recorded_ = false;
+};
+#endif
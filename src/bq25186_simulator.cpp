@@ -0,0 +1,220 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ */
+
+#ifndef bq25186_simulator_cpp
+#define bq25186_simulator_cpp
+#include "bq25186_simulator.h"
+
+static const uint8_t bq25186_simulator_defaults_[] = {	//Register values after reset, from the datasheet
+	0x00, 0x00, 0x00, 0x46, 0x05, 0x2c, 0x56, 0x84, 0x4d, 0x11, 0x40, 0x00, 0xc0
+};
+static const uint8_t bq25186_simulator_writable_[] = {	//Bits that can be written, the rest are status or device ID
+	0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0
+};
+static const uint8_t bq25186_simulator_flags_[] = {		//Bits that latch and are cleared on read
+	0x00, 0x07, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+bq25186_simulator::bq25186_simulator() {
+	reset();
+}
+void bq25186_simulator::reset() {
+	for(uint8_t index = 0; index < bq25186_number_of_registers_; index++) {
+		registers_[index] = bq25186_simulator_defaults_[index];
+	}
+	pointer_ = 0;
+}
+uint8_t bq25186_simulator::write(uint8_t address, const uint8_t *data, uint8_t length, bool stop) {
+	(void)stop;									//A stop doesn't change the register pointer
+	if(address != bq25186_i2c_address_) {
+		return BQ25186_BUS_NACK_ADDRESS;
+	}
+	transactions_++;
+	uint8_t i2cError = injected_error_();
+	if(i2cError != BQ25186_BUS_OK) {
+		return i2cError;
+	}
+	bytes_written_ += length;
+	if(length == 0) {
+		return BQ25186_BUS_OK;
+	}
+	pointer_ = data[0];							//First byte is always the register
+	if(length > 1 && write_fault_count_ > 0) {
+		write_fault_count_--;
+		return BQ25186_BUS_OK;					//Acknowledged, but lost
+	}
+	for(uint8_t index = 1; index < length; index++) {
+		if(pointer_ >= bq25186_number_of_registers_) {
+			return BQ25186_BUS_NACK_DATA;
+		}
+		uint8_t writable = bq25186_simulator_writable_[pointer_];
+		registers_[pointer_] = (registers_[pointer_] & ~writable) | (data[index] & writable);
+		if(pointer_ == 0x09 && ((registers_[0x09] & 0x80) || (registers_[0x09] & 0x60) == 0x60)) {	//Software or hardware reset
+			reset();
+			return BQ25186_BUS_OK;
+		}
+		pointer_++;								//Auto-increment
+	}
+	return BQ25186_BUS_OK;
+}
+uint8_t bq25186_simulator::read(uint8_t address, uint8_t *data, uint8_t length, bool stop) {
+	(void)stop;
+	if(address != bq25186_i2c_address_) {
+		return BQ25186_BUS_NACK_ADDRESS;
+	}
+	transactions_++;
+	uint8_t i2cError = injected_error_();
+	if(i2cError != BQ25186_BUS_OK) {
+		return i2cError;
+	}
+	bytes_read_ += length;
+	update_model_();
+	for(uint8_t index = 0; index < length; index++) {
+		if(pointer_ < bq25186_number_of_registers_) {
+			data[index] = registers_[pointer_];
+			registers_[pointer_] &= ~bq25186_simulator_flags_[pointer_];	//Clear on read
+			pointer_++;							//Auto-increment
+		} else {
+			data[index] = 0xff;					//Past the end of the register map
+		}
+	}
+	return BQ25186_BUS_OK;
+}
+void bq25186_simulator::set_status(uint8_t index, uint8_t value) {
+	if(index < 0x02) {
+		uint8_t live = ~bq25186_simulator_flags_[index];
+		registers_[index] = (registers_[index] & ~live) | (value & live);
+	}
+}
+void bq25186_simulator::raise_flags(uint8_t index, uint8_t flags) {
+	if(index < bq25186_number_of_registers_) {
+		registers_[index] |= flags & bq25186_simulator_flags_[index];
+	}
+}
+uint8_t bq25186_simulator::peek(uint8_t index) {
+	if(index < bq25186_number_of_registers_) {
+		return registers_[index];
+	}
+	return 0xff;
+}
+void bq25186_simulator::inject_error(uint8_t count, uint8_t error) {
+	error_count_ = count;
+	error_ = error;
+}
+void bq25186_simulator::inject_stuck_bus() {
+	stuck_ = true;
+}
+void bq25186_simulator::inject_write_fault(uint8_t count) {
+	write_fault_count_ = count;
+}
+void bq25186_simulator::set_transfer_delay(uint32_t microseconds) {
+	transfer_delay_ = microseconds;
+}
+bool bq25186_simulator::recover() {
+	stuck_ = false;
+	recoveries_++;
+	return true;
+}
+uint32_t bq25186_simulator::recoveries() {
+	return recoveries_;
+}
+uint8_t bq25186_simulator::injected_error_() {
+	if(transfer_delay_ > 0) {
+		delayMicroseconds(transfer_delay_);
+	}
+	if(stuck_) {
+		return BQ25186_BUS_TIMEOUT;
+	}
+	if(error_count_ > 0) {
+		error_count_--;
+		return error_;
+	}
+	return BQ25186_BUS_OK;
+}
+uint32_t bq25186_simulator::transactions() {
+	return transactions_;
+}
+uint32_t bq25186_simulator::bytes_written() {
+	return bytes_written_;
+}
+uint32_t bq25186_simulator::bytes_read() {
+	return bytes_read_;
+}
+void bq25186_simulator::reset_counters() {
+	transactions_ = 0;
+	bytes_written_ = 0;
+	bytes_read_ = 0;
+	recoveries_ = 0;
+}
+bq25186_simulator_mux::bq25186_simulator_mux(uint8_t address) : address_(address) {
+}
+uint8_t bq25186_simulator_mux::write(uint8_t address, const uint8_t *data, uint8_t length, bool stop) {
+	if(address == address_) {
+		if(length > 0) {
+			control_ = data[length - 1];			//The last byte written wins
+			selects_++;
+		}
+		return BQ25186_BUS_OK;
+	}
+	bq25186_bus *device = selected_(address);
+	if(device == nullptr) {
+		return BQ25186_BUS_NACK_ADDRESS;
+	}
+	return device->write(address, data, length, stop);
+}
+uint8_t bq25186_simulator_mux::read(uint8_t address, uint8_t *data, uint8_t length, bool stop) {
+	if(address == address_) {
+		for(uint8_t index = 0; index < length; index++) {
+			data[index] = control_;
+		}
+		return BQ25186_BUS_OK;
+	}
+	bq25186_bus *device = selected_(address);
+	if(device == nullptr) {
+		return BQ25186_BUS_NACK_ADDRESS;
+	}
+	return device->read(address, data, length, stop);
+}
+bq25186_bus *bq25186_simulator_mux::selected_(uint8_t address) {
+	(void)address;
+	bq25186_bus *device = nullptr;
+	for(uint8_t channel = 0; channel < 8; channel++) {
+		if((control_ & (1 << channel)) && devices_[channel] != nullptr) {
+			if(device != nullptr) {
+				return nullptr;						//Two chips answering at once, treat it as a failed transaction
+			}
+			device = devices_[channel];
+		}
+	}
+	return device;
+}
+bool bq25186_simulator_mux::recover() {
+	bool recovered = true;
+	for(uint8_t channel = 0; channel < 8; channel++) {
+		if(devices_[channel] != nullptr && devices_[channel]->recover() == false) {
+			recovered = false;
+		}
+	}
+	return recovered;							//The multiplexer keeps its control register through a stop
+}
+void bq25186_simulator_mux::attach(uint8_t channel, bq25186_bus &device) {
+	if(channel < 8) {
+		devices_[channel] = &device;
+	}
+}
+uint8_t bq25186_simulator_mux::get_control() {
+	return control_;
+}
+uint32_t bq25186_simulator_mux::selects() {
+	return selects_;
+}
+void bq25186_simulator_mux::reset_counters() {
+	selects_ = 0;
+}
+#endif
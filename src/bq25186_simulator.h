@@ -0,0 +1,74 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	A simulated BQ25186 register file, used in place of a real I²C bus to run the library without hardware
+ *
+ */
+
+#ifndef bq25186_simulator_h
+#define bq25186_simulator_h
+#include "bq25186_bus.h"
+
+class bq25186_simulator : public bq25186_bus {
+
+	public:
+		bq25186_simulator();
+		uint8_t write(uint8_t address, const uint8_t *data, uint8_t length, bool stop = true) override;
+		uint8_t read(uint8_t address, uint8_t *data, uint8_t length, bool stop = true) override;
+		void reset();														//Restore the datasheet reset defaults, as after power up or a register reset
+		void set_status(uint8_t index, uint8_t value);						//Set the live (non-flag) bits of status register 0x00 or 0x01
+		void raise_flags(uint8_t index, uint8_t flags);						//Latch flags in register 0x01 or 0x02, cleared when next read
+		uint8_t peek(uint8_t index);										//Register value without the side effects of a read
+		void inject_error(uint8_t count,									//Fail the next 'count' transactions with a BQ25186_BUS_* error
+			uint8_t error = BQ25186_BUS_NACK_ADDRESS);
+		void inject_stuck_bus();											//Time out every transaction until recover() is called
+		void inject_write_fault(uint8_t count);								//Acknowledge the next 'count' writes but don't store the data
+		void set_transfer_delay(uint32_t microseconds);						//Make every transaction take at least this long
+		bool recover() override;											//Clears a stuck bus
+		uint32_t recoveries();
+		uint32_t transactions();											//Count of every transaction addressed to the simulator
+		uint32_t bytes_written();
+		uint32_t bytes_read();
+		void reset_counters();
+	protected:
+		virtual void update_model_() {}										//Called before each read so a subclass can model the input, battery or die and set_status() to match
+	private:
+		static const uint8_t bq25186_i2c_address_ = 0x6a;
+		static const uint8_t bq25186_number_of_registers_ = 0x0d;
+		uint8_t registers_[bq25186_number_of_registers_];
+		uint8_t pointer_ = 0;												//Register pointer, auto-increments on each byte
+		uint8_t error_count_ = 0;
+		uint8_t error_ = BQ25186_BUS_OK;
+		bool stuck_ = false;
+		uint8_t write_fault_count_ = 0;
+		uint32_t transfer_delay_ = 0;
+		uint32_t recoveries_ = 0;
+		uint32_t transactions_ = 0;
+		uint32_t bytes_written_ = 0;
+		uint32_t bytes_read_ = 0;
+		uint8_t injected_error_();											//Consume one injected error, if any, after any transfer delay
+};
+
+class bq25186_simulator_mux : public bq25186_bus {						//A simulated TCA9548A style multiplexer with a device, eg. a bq25186_simulator, on each channel
+
+	public:
+		bq25186_simulator_mux(uint8_t address = 0x70);
+		uint8_t write(uint8_t address, const uint8_t *data, uint8_t length, bool stop = true) override;
+		uint8_t read(uint8_t address, uint8_t *data, uint8_t length, bool stop = true) override;
+		bool recover() override;											//Recovers every attached device
+		void attach(uint8_t channel, bq25186_bus &device);					//Channel 0-7
+		uint8_t get_control();												//One bit per connected channel
+		uint32_t selects();													//Writes to the multiplexer's control register
+		void reset_counters();
+	private:
+		uint8_t address_;
+		uint8_t control_ = 0;
+		bq25186_bus *devices_[8] = {};
+		uint32_t selects_ = 0;
+		bq25186_bus *selected_(uint8_t address);							//The device on a connected channel, as they all share an address more than one is a collision
+};
+#endif
@@ -0,0 +1,127 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ */
+
+#ifndef bq25186_solar_cpp
+#define bq25186_solar_cpp
+#include "bq25186_solar.h"
+
+bq25186_solar::bq25186_solar(bq25186 &charger) : charger_(&charger) {
+}
+bq25186_solar::~bq25186_solar() {
+	charger_->remove_fault_latch(faults_);
+}
+bool bq25186_solar::begin(uint8_t vindpm, uint8_t ilim) {
+	ilim_ = ilim < minimum_ilim_ ? minimum_ilim_ : (ilim > maximum_ilim_ ? maximum_ilim_ : ilim);
+	trend_ = 0;
+	trend_samples_ = 0;
+	ceiling_ = 0xff;
+	probe_samples_ = hysteresis_;
+	sample_timer_ = millis();
+	write_limit_.reset();							//The first step can be written straight away
+	if(charger_->add_fault_latch(faults_) == false) {
+		return false;
+	}
+	charger_->take_fault_latch(faults_);			//Only flags from now on
+	return charger_->set_vindpm(vindpm) && charger_->set_ilim(ilim_);
+}
+/*
+The BQ25186 holds the panel at VINDPM by reducing the input current, and VINDPM being active means the panel is past its knee. ILIM being active means the
+panel could give more than ILIM allows. So step ILIM down while VINDPM is active, up while ILIM is active and hold when neither is, which is the battery or
+system taking less than either limit. This settles either side of the maximum power point and follows it as the light changes.
+
+The setting where VINDPM was last seen is remembered and each time a step back up to it finds VINDPM again, the tracker waits twice as long before the next
+try. So in steady light it stays just below the knee with occasional probes rather than writing ILIM every few samples.
+*/
+bool bq25186_solar::update() {
+	if(millis() - sample_timer_ < sample_interval_) {
+		return false;
+	}
+	sample_timer_ = millis();
+	charger_->invalidate_status_cache();			//One status burst per sample, whatever the cache time-to-live is
+	bq25186_status status;
+	if(charger_->read_status(status) == false) {
+		trend_samples_ = 0;
+		return false;
+	}
+	uint16_t faults = charger_->take_fault_latch(faults_);	//Includes the flags in this sample's burst, and any other code's reads since the last
+	bool vindpmActive = status.vindpm_active || (faults & BQ25186_FLAG_VINDPM_ACTIVE);
+	bool ilimActive = status.ilim_active || (faults & BQ25186_FLAG_ILIM_ACTIVE);
+	int8_t direction = 0;
+	if(status.vin_pgood == false || vindpmActive) {	//No input at all also steps down, so the panel isn't overloaded as it wakes up
+		direction = -1;
+	} else if(ilimActive) {
+		direction = 1;
+	}
+	if(direction != trend_) {
+		trend_ = direction;
+		trend_samples_ = 0;
+	}
+	int16_t setting = bq25186_fields::ilim::to_code(ilim_);
+	if(direction > 0 && setting >= ceiling_) {
+		ceiling_ = 0xff;							//At the old knee without VINDPM, so there is more light
+		probe_samples_ = hysteresis_;
+	}
+	uint8_t required = (direction > 0 && setting + step_ >= ceiling_) ? probe_samples_ : hysteresis_;
+	if(direction == 0 || ++trend_samples_ < required) {
+		return false;
+	}
+	if(write_limit_.allowed() == false) {
+		return false;								//Keep the trend, the step happens when writes are allowed again
+	}
+	if(direction < 0) {
+		if(setting != ceiling_) {
+			probe_samples_ = hysteresis_;			//A new knee
+		} else if(probe_samples_ < bq25186_solar_max_probe_samples_) {
+			probe_samples_ *= 2;					//The same knee again, back off
+		}
+		ceiling_ = setting;
+	}
+	setting += direction * step_;
+	int16_t minimum = bq25186_fields::ilim::to_code(minimum_ilim_);
+	int16_t maximum = bq25186_fields::ilim::to_code(maximum_ilim_);
+	setting = setting < minimum ? minimum : (setting > maximum ? maximum : setting);
+	uint8_t ilim = bq25186_fields::ilim::from_code(setting);
+	if(ilim == ilim_) {
+		return false;								//Already at the limit
+	}
+	if(charger_->set_ilim(ilim)) {
+		ilim_ = ilim;
+		write_limit_.record();						//Only writes that happened count, a failed one is tried again next sample
+		writes_++;
+		trend_samples_ = 0;							//Observe the new setting before stepping again
+		return true;
+	}
+	return false;
+}
+void bq25186_solar::set_sample_interval(uint32_t milliseconds) {
+	sample_interval_ = milliseconds;
+}
+void bq25186_solar::set_step(uint8_t settings) {
+	step_ = settings > 0 ? settings : 1;
+}
+void bq25186_solar::set_hysteresis(uint8_t samples) {
+	hysteresis_ = samples > 0 ? samples : 1;
+	probe_samples_ = hysteresis_;
+}
+void bq25186_solar::set_min_write_interval(uint32_t milliseconds) {
+	write_limit_.set_min_interval(milliseconds);
+}
+void bq25186_solar::set_ilim_range(uint8_t minimum, uint8_t maximum) {
+	if(bq25186_fields::ilim::valid(minimum) && bq25186_fields::ilim::valid(maximum) && minimum <= maximum) {
+		minimum_ilim_ = minimum;
+		maximum_ilim_ = maximum;
+	}
+}
+uint8_t bq25186_solar::get_ilim() {
+	return ilim_;
+}
+uint32_t bq25186_solar::get_writes() {
+	return writes_;
+}
+#endif
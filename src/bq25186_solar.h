@@ -0,0 +1,50 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Perturb and observe power tracking for a solar panel input, stepping ILIM from the VINDPM and ILIM status bits
+ *
+ */
+
+#ifndef bq25186_solar_h
+#define bq25186_solar_h
+#include "bq25186.h"
+#include "bq25186_rate_limiter.h"
+
+class bq25186_solar {
+
+	public:
+		bq25186_solar(bq25186 &charger);
+		~bq25186_solar();
+		bool begin(uint8_t vindpm = BQ25186_VINDPM_4_5,						//Set the voltage the panel is held at and the starting input current limit, false if the charger has no fault latch free
+			uint8_t ilim = BQ25186_ILIM_100_MA);
+		bool update();														//Call regularly, takes a status sample each interval and steps ILIM, true if it changed
+		void set_sample_interval(uint32_t milliseconds);					//Time between status samples, default 1000ms
+		void set_step(uint8_t settings);									//How many ILIM settings each step moves, default 1
+		void set_hysteresis(uint8_t samples);								//How many samples in a row must agree before a step, default 2
+		void set_min_write_interval(uint32_t milliseconds);					//Least time between ILIM writes, default 1000ms, 0 for no limit
+		void set_ilim_range(uint8_t minimum, uint8_t maximum);				//Limits as BQ25186_ILIM_* values, default 50mA to 1050mA
+		uint8_t get_ilim();													//The ILIM set by the tracker as a BQ25186_ILIM_* value
+		uint32_t get_writes();												//How many times the tracker has written ILIM
+	private:
+		bq25186 *charger_;
+		uint8_t ilim_ = BQ25186_ILIM_100_MA;
+		uint8_t minimum_ilim_ = BQ25186_ILIM_50_MA;
+		uint8_t maximum_ilim_ = BQ25186_ILIM_1050_MA;
+		uint8_t step_ = 1;
+		uint8_t hysteresis_ = 2;
+		int8_t trend_ = 0;													//Direction the recent samples agree on, -1 down, 1 up or 0 hold
+		uint8_t trend_samples_ = 0;											//How many samples in a row have agreed
+		uint8_t ceiling_ = 0xff;											//ILIM setting, as 0-7, where VINDPM was last seen
+		uint8_t probe_samples_ = 2;											//Samples needed before stepping back up to the ceiling
+		static const uint8_t bq25186_solar_max_probe_samples_ = 64;
+		uint16_t faults_ = 0;												//Flags the charger has read since the last sample, so flags raised between samples are seen
+		uint32_t sample_interval_ = 1e3;
+		uint32_t sample_timer_ = 0;
+		bq25186_rate_limiter write_limit_;
+		uint32_t writes_ = 0;
+};
+#endif
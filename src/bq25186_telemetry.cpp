@@ -0,0 +1,192 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ */
+
+#ifndef bq25186_telemetry_cpp
+#define bq25186_telemetry_cpp
+#include "bq25186_telemetry.h"
+
+bq25186_telemetry::bq25186_telemetry(uint8_t *buffer, uint16_t size) : buffer_(buffer), size_(size) {
+}
+bool bq25186_telemetry::sample(bq25186 &charger) {
+	uint8_t registers[3];
+	if(charger.get_registers(0x00, 3, registers) == false) {
+		return false;
+	}
+	return append(registers, millis());
+}
+bool bq25186_telemetry::append(const uint8_t *registers, uint32_t timestamp) {
+	if(started_ == false) {
+		started_ = true;
+		base_timestamp_ = timestamp;					//The first record holds the whole of each non-zero register
+		last_timestamp_ = timestamp;
+	}
+	if(entries_ > 0 && memcmp(registers, last_registers_, 3) == 0 && last_samples_ < 0xffff) {
+		uint16_t samples = last_samples_ + 1;			//Unchanged, so extend the newest run by rewriting its tail
+		uint32_t duration = timestamp - last_timestamp_;
+		uint8_t trailerLength = varint_length_(samples) + varint_length_(duration);
+		length_ -= last_trailer_length_;
+		while(free_() < trailerLength) {
+			if(discard_oldest_(true) == false) {
+				length_ += last_trailer_length_;		//Too small to grow, keep the run as it was
+				return false;
+			}
+		}
+		write_varint_(samples);
+		write_varint_(duration);
+		last_samples_ = samples;
+		last_duration_ = duration;
+		last_trailer_length_ = trailerLength;
+		samples_++;
+		return true;
+	}
+	uint8_t header = bq25186_telemetry_header_;
+	uint8_t changed = 0;
+	for(uint8_t index = 0; index < 3; index++) {
+		if(registers[index] != last_registers_[index]) {
+			header |= 1 << index;
+			changed++;
+		}
+	}
+	uint32_t interval = timestamp - last_timestamp_;
+	uint16_t recordLength = 1 + varint_length_(interval) + changed + varint_length_(1) + varint_length_(0);
+	if(recordLength > size_) {
+		return false;
+	}
+	while(free_() < recordLength) {
+		if(discard_oldest_(false) == false) {			//The new record is checked to fit an empty buffer, so this only ends the loop if the state is inconsistent
+			return false;
+		}
+	}
+	write_byte_(header);
+	write_varint_(interval);
+	for(uint8_t index = 0; index < 3; index++) {
+		if(header & (1 << index)) {
+			write_byte_(registers[index] ^ last_registers_[index]);
+		}
+	}
+	write_varint_(1);
+	write_varint_(0);
+	memcpy(last_registers_, registers, 3);
+	last_timestamp_ = timestamp;
+	last_samples_ = 1;
+	last_duration_ = 0;
+	last_trailer_length_ = varint_length_(1) + varint_length_(0);
+	entries_++;
+	samples_++;
+	return true;
+}
+void bq25186_telemetry::clear() {
+	head_ = 0;
+	length_ = 0;
+	entries_ = 0;
+	samples_ = 0;
+	samples_discarded_ = 0;
+	started_ = false;
+	last_samples_ = 0;
+	last_trailer_length_ = 0;
+	memset(base_registers_, 0, 3);
+	memset(last_registers_, 0, 3);
+}
+uint16_t bq25186_telemetry::used() {
+	return length_;
+}
+uint16_t bq25186_telemetry::entries() {
+	return entries_;
+}
+uint32_t bq25186_telemetry::samples() {
+	return samples_;
+}
+uint32_t bq25186_telemetry::samples_discarded() {
+	return samples_discarded_;
+}
+uint16_t bq25186_telemetry::free_() {
+	return size_ - length_;
+}
+void bq25186_telemetry::write_byte_(uint8_t value) {
+	buffer_[(head_ + length_) % size_] = value;
+	length_++;
+}
+void bq25186_telemetry::write_varint_(uint32_t value) {
+	while(value > 0x7f) {								//Seven bits at a time, least significant first, the top bit set if more follow
+		write_byte_(uint8_t(value) | 0x80);
+		value >>= 7;
+	}
+	write_byte_(uint8_t(value));
+}
+uint8_t bq25186_telemetry::read_byte_(uint16_t &index) const {
+	uint8_t value = buffer_[index];
+	index = (index + 1) % size_;
+	return value;
+}
+uint32_t bq25186_telemetry::read_varint_(uint16_t &index) const {
+	uint32_t value = 0;
+	uint8_t shift = 0;
+	uint8_t byte;
+	do {
+		byte = read_byte_(index);
+		value |= uint32_t(byte & 0x7f) << shift;
+		shift += 7;
+	} while(byte & 0x80);
+	return value;
+}
+uint8_t bq25186_telemetry::varint_length_(uint32_t value) {
+	uint8_t length = 1;
+	while(value > 0x7f) {
+		value >>= 7;
+		length++;
+	}
+	return length;
+}
+bool bq25186_telemetry::discard_oldest_(bool keepNewest) {
+	if(entries_ == 0 || (keepNewest && entries_ == 1)) {
+		return false;
+	}
+	uint16_t samples;
+	uint32_t duration;
+	uint16_t next = decode_(head_, base_timestamp_, base_registers_, samples, duration);
+	entries_--;
+	if(entries_ == 0) {
+		length_ = 0;									//A record that filled the whole buffer ends where it started, so its length can't be worked out from the indices
+	} else {
+		length_ -= (next + size_ - head_) % size_;
+	}
+	head_ = next;
+	samples_discarded_ += samples;
+	return true;
+}
+uint16_t bq25186_telemetry::decode_(uint16_t index, uint32_t &timestamp, uint8_t *registers, uint16_t &samples, uint32_t &duration) const {
+	uint8_t header = read_byte_(index);
+	timestamp += read_varint_(index);
+	for(uint8_t bit = 0; bit < 3; bit++) {
+		if(header & (1 << bit)) {
+			registers[bit] ^= read_byte_(index);
+		}
+	}
+	samples = read_varint_(index);
+	duration = read_varint_(index);
+	return index;
+}
+bq25186_telemetry_iterator::bq25186_telemetry_iterator(const bq25186_telemetry &telemetry) :
+	telemetry_(&telemetry),
+	index_(telemetry.head_),
+	remaining_(telemetry.entries_),
+	timestamp_(telemetry.base_timestamp_) {
+	memcpy(registers_, telemetry.base_registers_, 3);
+}
+bool bq25186_telemetry_iterator::next(bq25186_telemetry_entry &entry) {
+	if(remaining_ == 0) {
+		return false;
+	}
+	index_ = telemetry_->decode_(index_, timestamp_, registers_, entry.samples, entry.duration);
+	remaining_--;
+	entry.timestamp = timestamp_;
+	memcpy(entry.registers, registers_, 3);
+	return true;
+}
+#endif
@@ -0,0 +1,80 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Compact history of the status registers 0x00-0x02, kept in a buffer you provide
+ *
+ */
+
+#ifndef bq25186_telemetry_h
+#define bq25186_telemetry_h
+#include "bq25186.h"
+
+struct bq25186_telemetry_entry {										//A run of identical status samples, as returned by bq25186_telemetry_iterator
+	uint32_t timestamp;														//millis() of the first sample
+	uint32_t duration;														//Milliseconds from the first to the last sample
+	uint16_t samples;														//How many samples in a row had these values
+	uint8_t registers[3];													//Registers 0x00-0x02
+};
+
+class bq25186_telemetry {
+
+	public:
+		bq25186_telemetry(uint8_t *buffer, uint16_t size);					//Records are kept in 'buffer', the oldest are discarded when it is full
+		bool sample(bq25186 &charger);										//Read the status registers and append them, false on an I²C error or if append() fails
+		bool append(const uint8_t *registers, uint32_t timestamp);			//Append three status register values, false if the buffer is too small for a record
+		void clear();
+		uint16_t used();													//Bytes of the buffer in use
+		uint16_t entries();													//Runs held, each one is an entry from the iterator
+		uint32_t samples();													//Samples appended since the last clear()
+		uint32_t samples_discarded();										//Samples in runs discarded to make room
+	private:
+		friend class bq25186_telemetry_iterator;
+		/*
+		Each run is one record of a header byte with a bit set for each register that changed, the milliseconds since the start of the previous run, the
+		XOR of each changed register with the previous run then the number of samples and the duration. The last two are at the end so a repeated sample
+		only rewrites the tail of the newest record. When the oldest record is discarded it is folded into base_ so the next one still decodes.
+		*/
+		uint8_t *buffer_;
+		uint16_t size_;
+		uint16_t head_ = 0;													//Index of the oldest record
+		uint16_t length_ = 0;												//Bytes in use
+		uint16_t entries_ = 0;
+		uint32_t samples_ = 0;
+		uint32_t samples_discarded_ = 0;
+		uint32_t base_timestamp_ = 0;										//State before the oldest record
+		uint8_t base_registers_[3] = {};
+		bool started_ = false;
+		uint32_t last_timestamp_ = 0;										//The newest record
+		uint8_t last_registers_[3] = {};
+		uint16_t last_samples_ = 0;
+		uint32_t last_duration_ = 0;
+		uint8_t last_trailer_length_ = 0;									//Bytes of samples and duration at the end of the newest record
+		static const uint8_t bq25186_telemetry_header_ = 0x80;				//Marks the start of a record, the low three bits are the changed registers
+		uint16_t free_();
+		void write_byte_(uint8_t value);									//At the end of the used part of the buffer
+		void write_varint_(uint32_t value);
+		uint8_t read_byte_(uint16_t &index) const;
+		uint32_t read_varint_(uint16_t &index) const;
+		static uint8_t varint_length_(uint32_t value);
+		bool discard_oldest_(bool keepNewest);								//Fold the oldest record into the base state, optionally never the newest as it is being extended
+		uint16_t decode_(uint16_t index, uint32_t &timestamp,				//Apply the record at index to a timestamp and registers, returns the next index
+			uint8_t *registers, uint16_t &samples, uint32_t &duration) const;
+};
+
+class bq25186_telemetry_iterator {										//Walks the history from oldest to newest, appending while iterating invalidates it
+
+	public:
+		bq25186_telemetry_iterator(const bq25186_telemetry &telemetry);
+		bool next(bq25186_telemetry_entry &entry);							//The next run, false once all have been returned
+	private:
+		const bq25186_telemetry *telemetry_;
+		uint16_t index_;
+		uint16_t remaining_;
+		uint32_t timestamp_;
+		uint8_t registers_[3];
+};
+#endif
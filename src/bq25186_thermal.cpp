@@ -0,0 +1,155 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ */
+
+#ifndef bq25186_thermal_cpp
+#define bq25186_thermal_cpp
+#include "bq25186_thermal.h"
+
+bq25186_thermal::bq25186_thermal(bq25186 &charger) : charger_(&charger) {
+}
+bq25186_thermal::~bq25186_thermal() {
+	charger_->remove_fault_latch(faults_);
+}
+bool bq25186_thermal::begin(uint16_t ichg, uint8_t thermReg) {
+	target_ichg_ = ichg;
+	quiet_samples_ = 0;
+	ceiling_ = 0xffff;
+	probe_samples_ = hysteresis_;
+	failures_ = 0;
+	fallback_ = false;
+	sample_timer_ = millis();
+	if(charger_->add_fault_latch(faults_) == false) {
+		return false;
+	}
+	charger_->take_fault_latch(faults_);			//Only flags from now on
+	if(charger_->set_therm_reg(thermReg) == false) {
+		return false;
+	}
+	ichg_ = safe_ichg_ < target_ichg_ ? safe_ichg_ : target_ichg_;	//Start low and work up, rather than start with a foldback
+	if(charger_->set_ichg(ichg_) == false) {
+		return false;
+	}
+	write_limit_.record();
+	return true;
+}
+/*
+When the die reaches the THERM_REG threshold the BQ25186 cuts the charge current itself, in large steps, then lets it back up and so oscillates. Instead step
+ICHG down by two steps whenever thermal regulation is seen and back up by one after a few quiet samples, which holds the die just below the threshold. The
+ICHG where thermal regulation was last seen is remembered and each time a step back up to it regulates again the governor waits twice as long before the
+next try, so it settles rather than hunting. While TS is warm or cool the charger is already reducing the current so the governor only holds, and if TS is
+too hot or cold or the status can't be read it falls back to the safe current.
+*/
+bool bq25186_thermal::update() {
+	if(millis() - sample_timer_ < sample_interval_) {
+		return false;
+	}
+	sample_timer_ = millis();
+	charger_->invalidate_status_cache();			//One status burst per sample, whatever the cache time-to-live is
+	bq25186_status status;
+	if(charger_->read_status(status) == false) {
+		if(failures_ < bq25186_thermal_max_failures_) {
+			failures_++;
+		}
+		if(failures_ >= bq25186_thermal_max_failures_ && fallback_ == false && write_ichg_(safe_ichg_, true)) {
+			fallback_ = true;						//Only once the safe current is set, otherwise try again next sample
+			return true;
+		}
+		return false;
+	}
+	failures_ = 0;
+	uint16_t faults = charger_->take_fault_latch(faults_);	//Includes the flags in this sample's burst, and any other code's reads since the last
+	bool thermal = status.thermreg_active || (faults & BQ25186_FLAG_THERMREG_ACTIVE);
+	if(status.ts_stat == BQ25186_TS_TOO_HOT_OR_COLD) {
+		quiet_samples_ = 0;
+		if(fallback_ == false && write_ichg_(safe_ichg_, true)) {	//Safety first, no rate limit
+			fallback_ = true;
+			return true;
+		}
+		return false;
+	}
+	if(fallback_) {
+		fallback_ = false;							//Work back up from the safe current
+		ceiling_ = 0xffff;
+		probe_samples_ = hysteresis_;
+	}
+	if(thermal) {
+		quiet_samples_ = 0;
+		if(ichg_ == ceiling_ && probe_samples_ < bq25186_thermal_max_probe_samples_) {
+			probe_samples_ *= 2;					//The same ceiling again, back off
+		} else if(ichg_ != ceiling_) {
+			probe_samples_ = hysteresis_;
+		}
+		ceiling_ = ichg_;
+		uint16_t down = 2 * step_;
+		return write_ichg_(ichg_ > minimum_ichg_ + down ? ichg_ - down : minimum_ichg_, false);
+	}
+	if(status.ts_stat != BQ25186_TS_NORMAL) {
+		quiet_samples_ = 0;							//Warm or cool, the charger is already reducing the current
+		return false;
+	}
+	if(ichg_ >= target_ichg_) {
+		return false;
+	}
+	if(ichg_ >= ceiling_) {
+		ceiling_ = 0xffff;							//Quiet at the old ceiling, so it is cooler now
+		probe_samples_ = hysteresis_;
+	}
+	uint16_t up = ichg_ + step_ < target_ichg_ ? ichg_ + step_ : target_ichg_;
+	uint8_t required = up >= ceiling_ ? probe_samples_ : hysteresis_;
+	if(++quiet_samples_ < required) {
+		return false;
+	}
+	if(write_ichg_(up, false)) {
+		quiet_samples_ = 0;							//Observe the new setting before stepping again
+		return true;
+	}
+	return false;
+}
+bool bq25186_thermal::write_ichg_(uint16_t milliamps, bool force) {
+	if(milliamps == ichg_ && force == false) {
+		return false;
+	}
+	if(force == false && write_limit_.allowed() == false) {
+		return false;								//Try again on a later sample
+	}
+	if(charger_->set_ichg(milliamps)) {
+		uint16_t ichg = charger_->get_ichg();		//From the cache, the nearest current the register can hold
+		ichg_ = ichg > 0 ? ichg : milliamps;
+		write_limit_.record();						//Only writes that happened count, a failed one is tried again next sample
+		writes_++;
+		return true;
+	}
+	return false;
+}
+void bq25186_thermal::set_sample_interval(uint32_t milliseconds) {
+	sample_interval_ = milliseconds;
+}
+void bq25186_thermal::set_step(uint16_t milliamps) {
+	step_ = milliamps > 0 ? milliamps : 1;
+}
+void bq25186_thermal::set_hysteresis(uint8_t samples) {
+	hysteresis_ = samples > 0 ? samples : 1;
+	probe_samples_ = hysteresis_;
+}
+void bq25186_thermal::set_min_write_interval(uint32_t milliseconds) {
+	write_limit_.set_min_interval(milliseconds);
+}
+void bq25186_thermal::set_safe_ichg(uint16_t milliamps) {
+	safe_ichg_ = milliamps;
+}
+uint16_t bq25186_thermal::get_ichg() {
+	return ichg_;
+}
+bool bq25186_thermal::in_fallback() {
+	return fallback_;
+}
+uint32_t bq25186_thermal::get_writes() {
+	return writes_;
+}
+#endif
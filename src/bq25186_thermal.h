@@ -0,0 +1,55 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Charge current governor that steps ICHG in fine steps to stay just below thermal regulation
+ *
+ */
+
+#ifndef bq25186_thermal_h
+#define bq25186_thermal_h
+#include "bq25186.h"
+#include "bq25186_rate_limiter.h"
+
+class bq25186_thermal {
+
+	public:
+		bq25186_thermal(bq25186 &charger);
+		~bq25186_thermal();
+		bool begin(uint16_t ichg,											//The charge current to aim for in mA, and the die temperature to stay below, false if the charger has no fault latch free
+			uint8_t thermReg = BQ25186_THERM_REG_100C);
+		bool update();														//Call regularly, takes a status sample each interval and steps ICHG, true if it changed
+		void set_sample_interval(uint32_t milliseconds);					//Time between status samples, default 1000ms
+		void set_step(uint16_t milliamps);									//Step up in mA, steps down are twice this, default 10mA
+		void set_hysteresis(uint8_t samples);								//Samples without thermal regulation before a step up, default 3
+		void set_min_write_interval(uint32_t milliseconds);					//Least time between ICHG writes, default 1000ms, 0 for no limit
+		void set_safe_ichg(uint16_t milliamps);								//Used if the status can't be read or TS is too hot or cold, default 100mA
+		uint16_t get_ichg();												//The charge current set by the governor in mA
+		bool in_fallback();													//True while the safe charge current is in use
+		uint32_t get_writes();												//How many times the governor has written ICHG
+	private:
+		bq25186 *charger_;
+		uint16_t target_ichg_ = 0;											//mA
+		uint16_t ichg_ = 0;
+		uint16_t safe_ichg_ = 100;
+		uint16_t minimum_ichg_ = 5;
+		uint16_t step_ = 10;
+		uint8_t hysteresis_ = 3;
+		uint8_t quiet_samples_ = 0;											//Samples in a row without thermal regulation
+		uint16_t ceiling_ = 0xffff;											//ICHG where thermal regulation was last seen
+		uint8_t probe_samples_ = 3;											//Samples needed before stepping back up to the ceiling
+		static const uint8_t bq25186_thermal_max_probe_samples_ = 64;
+		static const uint8_t bq25186_thermal_max_failures_ = 3;				//Failed samples in a row before falling back to the safe current
+		uint8_t failures_ = 0;
+		bool fallback_ = false;
+		uint16_t faults_ = 0;												//Flags the charger has read since the last sample
+		uint32_t sample_interval_ = 1e3;
+		uint32_t sample_timer_ = 0;
+		bq25186_rate_limiter write_limit_;
+		uint32_t writes_ = 0;
+		bool write_ichg_(uint16_t milliamps, bool force);					//Rate limited unless forced, true if ICHG changed
+};
+#endif
@@ -0,0 +1,29 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Checks shared by the host tests in this directory, each test is a standalone program that exits with 1 if any check failed
+ *
+ */
+
+#ifndef bq25186_test_h
+#define bq25186_test_h
+#include <stdio.h>
+
+static unsigned int bq25186_test_failures = 0;
+
+#define CHECK(condition) do {															\
+		if(!(condition)) {																\
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);		\
+			bq25186_test_failures++;													\
+		}																				\
+	} while(0)
+
+static int bq25186_test_result(const char *name) {								//Return this from main()
+	printf("%s,%s\n", name, bq25186_test_failures == 0 ? "pass" : "FAIL");
+	return bq25186_test_failures == 0 ? 0 : 1;
+}
+#endif
@@ -0,0 +1,137 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Drives the update() state machine through the async queue against bq25186_simulator
+ *
+ *	g++ -std=gnu++11 -Isrc src/bq25186*.cpp tests/test_async.cpp -o test_async && ./test_async
+ *
+ */
+
+#include "bq25186.h"
+#include "bq25186_simulator.h"
+#include "bq25186_test.h"
+
+bq25186_simulator simulator;
+bq25186 charger;
+uint8_t callbacks = 0;
+bool lastSuccess = false;
+
+void requestDone(bool success) {
+	callbacks++;
+	lastSuccess = success;
+}
+void setRegister(uint8_t index, uint8_t value) {					//Change the device behind the library's back
+	uint8_t data[2] = {index, value};
+	simulator.write(0x6a, data, 2);
+}
+void start() {
+	simulator.reset();
+	charger.begin(simulator);
+	callbacks = 0;
+	lastSuccess = false;
+}
+
+void queuedRead() {													//Address then data, one phase per update()
+	start();
+	simulator.set_status(0x00, BQ25186_CC_CHARGING | BQ25186_POWER_GOOD);
+	CHECK(charger.queue_read(0x00, 3, requestDone));
+	CHECK(charger.async_busy());
+	simulator.reset_counters();
+	CHECK(charger.update() == true);
+	CHECK(simulator.transactions() == 1);
+	CHECK(callbacks == 0);
+	CHECK(charger.update() == false);
+	CHECK(simulator.transactions() == 2);
+	CHECK(callbacks == 1 && lastSuccess);
+	CHECK(charger.async_busy() == false);
+	simulator.reset_counters();
+	CHECK(charger.chg_stat() == BQ25186_CC_CHARGING);				//Served from the cache the read refreshed
+	CHECK(simulator.transactions() == 0);
+	CHECK(charger.update() == false);								//Nothing left to do
+	CHECK(simulator.transactions() == 0);
+}
+void queuedWrite() {												//The register is cached, so a single write
+	start();
+	uint8_t value;
+	charger.get_registers(0x04, 1, &value);
+	simulator.reset_counters();
+	CHECK(charger.queue_write(0x04, BQ25186_I2C_BITMASK_7, BQ25186_CHG_DISABLED, requestDone));
+	CHECK(charger.update() == false);
+	CHECK(simulator.transactions() == 1);
+	CHECK(callbacks == 1 && lastSuccess);
+	CHECK((simulator.peek(0x04) & BQ25186_I2C_BITMASK_7) == BQ25186_CHG_DISABLED);
+}
+void queuedWriteUncached() {										//Read-modify-write, three phases
+	start();
+	charger.invalidate_cache();
+	setRegister(0x04, simulator.peek(0x04) | BQ25186_I2C_BITMASK_0);
+	simulator.reset_counters();
+	CHECK(charger.queue_write(0x04, BQ25186_I2C_BITMASK_7, BQ25186_CHG_DISABLED, requestDone));
+	CHECK(charger.update() == true);
+	CHECK(charger.update() == true);
+	CHECK(callbacks == 0);
+	CHECK(charger.update() == false);
+	CHECK(simulator.transactions() == 3);
+	CHECK(callbacks == 1 && lastSuccess);
+	CHECK((simulator.peek(0x04) & BQ25186_I2C_BITMASK_7) == BQ25186_CHG_DISABLED);
+	CHECK(simulator.peek(0x04) & BQ25186_I2C_BITMASK_0);			//The other bits were read first and kept
+}
+void synchronousReadBetweenPhases() {								//A synchronous read moves the register pointer after the address phase
+	start();
+	setRegister(0x05, 0x5a);
+	charger.invalidate_cache();
+	CHECK(charger.queue_read(0x05, 1, requestDone));
+	CHECK(charger.update() == true);								//Pointer now at 0x05
+	charger.invalidate_status_cache();
+	charger.chg_stat();												//Pointer now past the status registers
+	simulator.reset_counters();
+	CHECK(charger.update() == true);								//Sends the address again rather than reading from the wrong register
+	CHECK(simulator.transactions() == 1);
+	CHECK(callbacks == 0);
+	CHECK(charger.update() == false);
+	CHECK(callbacks == 1 && lastSuccess);
+	uint8_t value = 0;
+	simulator.reset_counters();
+	CHECK(charger.get_registers(0x05, 1, &value));
+	CHECK(simulator.transactions() == 0);
+	CHECK(value == 0x5a);
+}
+void failedRequest() {												//An error completes the request with false and moves on
+	start();
+	CHECK(charger.queue_read(0x00, 3, requestDone));
+	CHECK(charger.queue_read(0x05, 1, requestDone));
+	simulator.inject_error(1, BQ25186_BUS_NACK_ADDRESS);
+	CHECK(charger.update() == true);
+	CHECK(callbacks == 1 && lastSuccess == false);
+	CHECK(charger.update() == true);
+	CHECK(charger.update() == false);
+	CHECK(callbacks == 2 && lastSuccess);
+}
+void queueLimits() {
+	start();
+	CHECK(charger.queue_read(0x00, 0) == false);
+	CHECK(charger.queue_read(0x0c, 2) == false);
+	CHECK(charger.queue_write(0x02, 0xff, 0) == false);				//Status registers are read only
+	for(uint8_t index = 0; index < BQ25186_ASYNC_QUEUE_LENGTH; index++) {
+		CHECK(charger.queue_read(0x00, 3, requestDone));
+	}
+	CHECK(charger.queue_read(0x00, 3, requestDone) == false);		//Full
+	while(charger.update()) {
+	}
+	CHECK(callbacks == BQ25186_ASYNC_QUEUE_LENGTH);
+	CHECK(charger.async_busy() == false);
+}
+
+int main() {
+	queuedRead();
+	queuedWrite();
+	queuedWriteUncached();
+	synchronousReadBetweenPhases();
+	failedRequest();
+	queueLimits();
+	return bq25186_test_result("test_async");
+}
@@ -0,0 +1,122 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Checks retries, bus recovery, write verification and the latency budget against faults injected by bq25186_simulator
+ *
+ *	g++ -std=gnu++11 -Isrc src/bq25186*.cpp tests/test_error_recovery.cpp -o test_error_recovery && ./test_error_recovery
+ *
+ */
+
+#include "bq25186.h"
+#include "bq25186_simulator.h"
+#include "bq25186_test.h"
+
+bq25186_simulator simulator;
+bq25186 charger;
+
+void start() {
+	simulator.reset();
+	simulator.set_transfer_delay(0);
+	charger.begin(simulator);
+	charger.set_retries(0);
+	charger.set_write_verify(false);
+	charger.set_latency_budget(0);
+}
+
+void noRetries() {													//By default the call fails with the bus error
+	start();
+	simulator.inject_error(1, BQ25186_BUS_NACK_ADDRESS);
+	CHECK(charger.set_ichg(300) == false);
+	CHECK(charger.get_last_error() == BQ25186_BUS_NACK_ADDRESS);
+	CHECK(charger.set_ichg(300));
+	CHECK(charger.get_last_error() == BQ25186_BUS_OK);
+}
+void unknownNotWritten() {											//A failed read leaves the register alone rather than guess its other fields
+	start();
+	charger.invalidate_cache();
+	uint8_t before = simulator.peek(0x04);
+	simulator.inject_error(1, BQ25186_BUS_NACK_ADDRESS);
+	simulator.reset_counters();
+	CHECK(charger.set_ichg(300) == false);
+	CHECK(simulator.transactions() == 1);								//The read only
+	CHECK(simulator.peek(0x04) == before);
+	CHECK(charger.set_ichg(300));										//Read then written
+	CHECK(charger.get_ichg() == 300);
+	CHECK(charger.get_last_error() == BQ25186_BUS_OK);
+}
+void retries() {
+	start();
+	charger.set_retries(2, 10);
+	simulator.inject_error(2, BQ25186_BUS_NACK_ADDRESS);
+	simulator.reset_counters();
+	CHECK(charger.set_ichg(300));										//Third attempt works
+	CHECK(simulator.transactions() == 3);
+	CHECK(charger.get_ichg() == 300);
+	simulator.inject_error(3, BQ25186_BUS_NACK_DATA);
+	CHECK(charger.set_ichg(200) == false);							//Out of retries
+	CHECK(charger.get_last_error() == BQ25186_BUS_NACK_DATA);
+	CHECK(simulator.recoveries() == 0);								//A NACK doesn't need the bus freeing
+}
+void recovery() {													//A stuck bus times out until recover() is called
+	start();
+	simulator.inject_stuck_bus();
+	CHECK(charger.set_ichg(300) == false);							//Without retries nothing frees it
+	CHECK(charger.get_last_error() == BQ25186_BUS_TIMEOUT);
+	CHECK(simulator.recoveries() == 0);
+	charger.set_retries(1, 10);
+	CHECK(charger.set_ichg(300));
+	CHECK(simulator.recoveries() == 1);
+	CHECK(charger.get_ichg() == 300);
+}
+void writeVerify() {												//Acknowledged writes that don't take are written again
+	start();
+	charger.set_retries(2, 10);
+	charger.set_write_verify(true);
+	simulator.inject_write_fault(1);
+	CHECK(charger.set_ichg(300));
+	charger.invalidate_cache();
+	CHECK(charger.get_ichg() == 300);								//From the device
+	simulator.inject_write_fault(3);
+	CHECK(charger.set_ichg(200) == false);
+	CHECK(charger.get_last_error() == BQ25186_BUS_VERIFY_FAILED);
+	charger.set_write_verify(false);
+	simulator.inject_write_fault(1);
+	CHECK(charger.set_ichg(400));									//Not noticed without verification
+}
+void latencyBudget() {
+	start();
+	simulator.set_transfer_delay(2000);
+	charger.get_ichg();												//Learn how long a transfer takes
+	charger.set_latency_budget(3000);
+	charger.invalidate_cache();
+	CHECK(charger.set_ichg(300) == false);							//Read then write won't fit
+	CHECK(charger.get_last_error() == BQ25186_BUS_OVER_BUDGET);
+	CHECK(charger.set_ichg(300));									//The register was read, so now it is a single write
+	charger.set_retries(3, 100);
+	simulator.inject_error(1, BQ25186_BUS_NACK_ADDRESS);
+	simulator.reset_counters();
+	uint32_t start = micros();
+	CHECK(charger.set_ichg(200) == false);							//A retry would run late
+	uint32_t elapsed = micros() - start;
+	CHECK(simulator.transactions() == 1);
+	CHECK(charger.get_last_error() == BQ25186_BUS_NACK_ADDRESS);		//The real error, not the budget
+	CHECK(elapsed < 2000 + 100 + 2000);								//Less than the transfer, backoff and retry would have taken
+	charger.set_latency_budget(10000);
+	simulator.inject_error(1, BQ25186_BUS_NACK_ADDRESS);
+	CHECK(charger.set_ichg(200));									//Room for the retry now
+	simulator.set_transfer_delay(0);
+}
+
+int main() {
+	noRetries();
+	unknownNotWritten();
+	retries();
+	recovery();
+	writeVerify();
+	latencyBudget();
+	return bq25186_test_result("test_error_recovery");
+}
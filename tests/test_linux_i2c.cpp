@@ -0,0 +1,112 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Runs bq25186_linux_i2c_bus over a fake file descriptor layer that passes the messages to bq25186_simulator
+ *
+ *	g++ -std=gnu++11 -Isrc src/bq25186*.cpp tests/test_linux_i2c.cpp -o test_linux_i2c && ./test_linux_i2c
+ *
+ */
+
+#include "bq25186.h"
+#include "bq25186_simulator.h"
+#include "bq25186_linux_i2c.h"
+#include "bq25186_test.h"
+#include <errno.h>
+#include <string.h>
+
+#define FAKE_FD 1000												//Never a real descriptor in this process
+
+bq25186_simulator simulator;
+uint8_t opens = 0;
+uint8_t closes = 0;
+uint8_t transfers = 0;
+
+class fake_bus : public bq25186_linux_i2c_bus {
+
+	public:
+		~fake_bus() {
+			close();												//So the fake close_device_() is used, not the system close()
+		}
+	protected:
+		int open_device_(const char *device) override {
+			opens++;
+			return strcmp(device, "/dev/i2c-1") == 0 ? FAKE_FD : -1;
+		}
+		void close_device_(int fd) override {
+			CHECK(fd == FAKE_FD);
+			closes++;
+		}
+		int transfer_(int fd, struct i2c_msg *messages, uint32_t count) override {
+			CHECK(fd == FAKE_FD);
+			transfers++;
+			for(uint32_t index = 0; index < count; index++) {
+				bool last = index == count - 1;
+				uint8_t result = (messages[index].flags & I2C_M_RD) ?
+					simulator.read(messages[index].addr, messages[index].buf, messages[index].len, last) :
+					simulator.write(messages[index].addr, messages[index].buf, messages[index].len, last);
+				if(result != BQ25186_BUS_OK) {
+					errno = result == BQ25186_BUS_TIMEOUT ? ETIMEDOUT : ENXIO;
+					return -1;
+				}
+			}
+			return count;
+		}
+};
+
+void combinedTransactions() {										//A register read is one ioctl() with a repeated start
+	fake_bus bus;
+	bq25186 charger;
+	CHECK(bus.open(2) == false);
+	CHECK(bus.open(1));
+	CHECK(charger.begin(bus));
+	simulator.set_status(0x00, BQ25186_CC_CHARGING | BQ25186_POWER_GOOD);
+	charger.invalidate_status_cache();
+	transfers = 0;
+	CHECK(charger.chg_stat() == BQ25186_CC_CHARGING);
+	CHECK(transfers == 1);
+	CHECK(charger.set_ilim_ma(200));
+	CHECK(charger.get_ilim_ma() == 200);
+}
+void errors() {
+	fake_bus bus;
+	bq25186 charger;
+	CHECK(bus.open(1));
+	CHECK(charger.begin(bus));
+	simulator.inject_error(3, BQ25186_BUS_NACK_ADDRESS);
+	charger.invalidate_status_cache();
+	CHECK(charger.chg_stat() == BQ25186_I2C_ERROR);
+	CHECK(charger.get_last_error() == BQ25186_BUS_NACK_ADDRESS);
+	bus.close();
+	uint8_t data = 0;
+	CHECK(bus.read(0x6a, &data, 1) == BQ25186_BUS_OTHER_ERROR);		//Closed
+}
+void fakeDescriptorClosed() {										//Only the fake close_device_() sees the fake descriptor
+	opens = 0;
+	closes = 0;
+	{
+		fake_bus bus;
+		CHECK(bus.open(1));
+		CHECK(bus.open(1));											//Reopening closes the first
+		CHECK(closes == 1);
+	}
+	CHECK(opens == 2);
+	CHECK(closes == 2);
+	errno = 0;
+	{
+		fake_bus bus;
+		bus.close();												//Never opened
+	}
+	CHECK(closes == 2);
+	CHECK(errno == 0);
+}
+
+int main() {
+	combinedTransactions();
+	errors();
+	fakeDescriptorClosed();
+	return bq25186_test_result("test_linux_i2c");
+}
@@ -0,0 +1,163 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Checks bq25186_manager polls round-robin by group within its budget, on simulated chips behind bq25186_simulator_mux
+ *
+ *	g++ -std=gnu++11 -Isrc src/bq25186*.cpp tests/test_manager.cpp -o test_manager && ./test_manager
+ *
+ */
+
+#include "bq25186.h"
+#include "bq25186_manager.h"
+#include "bq25186_mux.h"
+#include "bq25186_simulator.h"
+#include "bq25186_test.h"
+
+char readLog[64];														//Which charger each read was for, in order
+uint8_t readCount = 0;
+
+class tagged_bus : public bq25186_bus {								//Passes everything to a multiplexer channel, logging reads
+	public:
+		tagged_bus(bq25186_bus &bus, char tag) : bus_(&bus), tag_(tag) {}
+		uint8_t write(uint8_t address, const uint8_t *data, uint8_t length, bool stop = true) override {
+			return bus_->write(address, data, length, stop);
+		}
+		uint8_t read(uint8_t address, uint8_t *data, uint8_t length, bool stop = true) override {
+			if(readCount < sizeof(readLog) - 1) {
+				readLog[readCount++] = tag_;
+				readLog[readCount] = 0;
+			}
+			return bus_->read(address, data, length, stop);
+		}
+	private:
+		bq25186_bus *bus_;
+		char tag_;
+};
+
+bq25186_simulator chip0;
+bq25186_simulator chip1;
+bq25186_simulator chip2;
+bq25186_simulator_mux muxBus;
+bq25186_mux mux(muxBus);
+bq25186_mux_channel channel0(mux, 0);
+bq25186_mux_channel channel1(mux, 1);
+bq25186_mux_channel channel2(mux, 2);
+tagged_bus busA(channel0, 'A');										//Two chargers on one chip stand in for a group with more than one charger
+tagged_bus busB(channel0, 'B');
+tagged_bus busC(channel1, 'C');
+tagged_bus busD(channel2, 'D');
+tagged_bus busE(channel2, 'E');
+bq25186 chargerA;
+bq25186 chargerB;
+bq25186 chargerC;
+bq25186 chargerD;
+bq25186 chargerE;
+
+void clearLog() {
+	readCount = 0;
+	readLog[0] = 0;
+}
+bool logIs(const char *expected) {
+	return strcmp(readLog, expected) == 0;
+}
+void start(bq25186_manager &manager) {								//Added out of order, polled sorted by group
+	CHECK(manager.add(chargerD, 2));
+	CHECK(manager.add(chargerA, 0));
+	CHECK(manager.add(chargerC, 1));
+	CHECK(manager.add(chargerE, 2));
+	CHECK(manager.add(chargerB, 0));
+	mux.invalidate();
+	muxBus.reset_counters();
+	clearLog();
+}
+
+void roundRobin() {
+	bq25186_manager manager;
+	start(manager);
+	CHECK(manager.count() == 5);
+	CHECK(manager.charger(0) == &chargerA && manager.charger(1) == &chargerB && manager.charger(2) == &chargerC);
+	CHECK(manager.charger(3) == &chargerD && manager.charger(4) == &chargerE && manager.charger(5) == nullptr);
+	CHECK(manager.group(1) == 0 && manager.group(2) == 1 && manager.group(4) == 2);
+	CHECK(manager.poll() == 5);										//The default budget covers every charger and group
+	CHECK(logIs("ABCDE"));
+	CHECK(muxBus.selects() == 3);									//One select per group, not per charger
+	CHECK(manager.cycles() == 1);
+	CHECK(manager.poll() == 5);
+	CHECK(logIs("ABCDEABCDE"));
+	CHECK(muxBus.selects() == 6);
+	CHECK(manager.cycles() == 2);
+}
+void withinBudget() {												//Reads plus selects never go over the budget, and the round carries on across polls
+	for(uint8_t budget = 2; budget <= 8; budget++) {
+		bq25186_manager manager;
+		start(manager);
+		CHECK(manager.set_budget(budget));
+		uint8_t polled = 0;
+		while(polled < 15) {
+			uint8_t reads = readCount;
+			uint32_t selects = muxBus.selects();
+			uint8_t read = manager.poll();
+			CHECK(read > 0);
+			CHECK(readCount - reads == read);
+			CHECK(readCount - reads + muxBus.selects() - selects <= budget);
+			polled += read;
+		}
+		for(uint8_t index = 0; index < polled; index++) {
+			CHECK(readLog[index] == "ABCDE"[index % 5]);			//The same order whatever the budget
+		}
+		CHECK(manager.cycles() == polled / 5);
+	}
+	bq25186_manager manager;
+	start(manager);
+	CHECK(manager.set_budget(3));
+	CHECK(manager.poll() == 2);										//Select group 0 and read A, then B
+	CHECK(manager.poll() == 1);										//Select group 1 and read C, selecting group 2 as well would be 4
+	CHECK(manager.poll() == 2);
+	CHECK(logIs("ABCDE"));
+	CHECK(manager.cycles() == 1);
+}
+void budgetTooSmall() {
+	bq25186_manager manager;
+	start(manager);
+	CHECK(manager.set_budget(1) == false);							//A read and its group select can't fit
+	CHECK(manager.poll() == 5);										//Still the default
+	CHECK(manager.set_budget(2));
+	CHECK(manager.set_budget(0));									//Back to the default
+	CHECK(manager.poll() == 5);
+}
+void failedChannel() {
+	bq25186_manager manager;
+	start(manager);
+	CHECK(manager.poll() == 5);
+	for(uint8_t index = 0; index < 5; index++) {
+		CHECK(manager.last_poll_ok(index));
+	}
+	chip1.inject_error(1, BQ25186_BUS_NACK_ADDRESS);				//Charger C, the only one on channel 1
+	CHECK(manager.poll() == 5);										//The rest are still read
+	CHECK(manager.last_poll_ok(0) && manager.last_poll_ok(1));
+	CHECK(manager.last_poll_ok(2) == false);
+	CHECK(manager.last_poll_ok(3) && manager.last_poll_ok(4));
+	CHECK(manager.last_poll_ok(5) == false);						//Out of range
+	CHECK(manager.poll() == 5);
+	CHECK(manager.last_poll_ok(2));									//Recovered on the next round
+}
+
+int main() {
+	muxBus.attach(0, chip0);
+	muxBus.attach(1, chip1);
+	muxBus.attach(2, chip2);
+	CHECK(chargerA.begin(busA));
+	CHECK(chargerB.begin(busB));
+	CHECK(chargerC.begin(busC));
+	CHECK(chargerD.begin(busD));
+	CHECK(chargerE.begin(busE));
+	roundRobin();
+	withinBudget();
+	budgetTooSmall();
+	failedChannel();
+	return bq25186_test_result("test_manager");
+}
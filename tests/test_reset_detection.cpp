@@ -0,0 +1,143 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Checks a reset of bq25186_simulator is noticed and the configuration restored as last written, not as it was when detection was set up
+ *
+ *	g++ -std=gnu++11 -Isrc src/bq25186*.cpp tests/test_reset_detection.cpp -o test_reset_detection && ./test_reset_detection
+ *
+ */
+
+#include "bq25186.h"
+#include "bq25186_simulator.h"
+#include "bq25186_test.h"
+
+class burst_failing_simulator : public bq25186_simulator {			//Can fail the restore burst while reads still work
+
+	public:
+		bool fail_bursts = false;
+		uint8_t write(uint8_t address, const uint8_t *data, uint8_t length, bool stop = true) override {
+			if(fail_bursts && length > 2) {
+				return BQ25186_BUS_NACK_DATA;
+			}
+			return bq25186_simulator::write(address, data, length, stop);
+		}
+};
+
+burst_failing_simulator simulator;
+bq25186 charger;
+uint8_t callbacks = 0;
+bool lastRestored = false;
+
+void chargerReset(bool restored) {
+	callbacks++;
+	lastRestored = restored;
+}
+void start() {														//Configured, then detection armed with ICHG at 200mA
+	simulator.reset();
+	CHECK(charger.begin(simulator));
+	CHECK(charger.set_ichg(200));
+	bq25186_config_image image;
+	CHECK(charger.get_config_image(image));
+	CHECK(charger.set_reset_detection(image));
+	charger.set_reset_callback(chargerReset);
+	callbacks = 0;
+	lastRestored = false;
+}
+uint16_t deviceIchg() {												//From the simulator, not the cache
+	charger.invalidate_cache();
+	return charger.get_ichg();
+}
+uint16_t deviceIlim() {
+	charger.invalidate_cache();
+	return charger.get_ilim_ma();
+}
+
+void laterWritesKept() {											//Changes after arming are restored, not reverted
+	start();
+	CHECK(charger.set_ichg(300));
+	CHECK(charger.set_ilim_ma(100));
+	simulator.reset();
+	charger.invalidate_status_cache();
+	charger.chg_stat();												//The status burst reads the sentinel and notices
+	CHECK(charger.get_reset_count() == 1);
+	CHECK(callbacks == 1 && lastRestored);
+	CHECK(deviceIchg() == 300);
+	CHECK(deviceIlim() == 100);
+}
+void stagedChangesKept() {											//Not restored part way through begin_config()
+	start();
+	charger.begin_config();
+	CHECK(charger.set_ilim_ma(200));
+	simulator.reset();
+	charger.invalidate_status_cache();
+	charger.chg_stat();
+	CHECK(charger.get_reset_count() == 1);
+	CHECK(callbacks == 0);											//Waits for commit()
+	CHECK(charger.get_ilim_ma() == 200);							//Still staged
+	CHECK(charger.commit());
+	CHECK(callbacks == 1 && lastRestored);
+	CHECK(deviceIlim() == 200);
+	CHECK(deviceIchg() == 200);										//The rest of the image, not the reset default
+}
+void restoredBetweenUpdates() {										//One transfer per update(), the restore is a phase of its own
+	start();
+	CHECK(charger.set_ichg(300));
+	simulator.reset();
+	CHECK(charger.queue_read(0x00, 5));								//Status and the sentinel
+	simulator.reset_counters();
+	CHECK(charger.update());										//Address
+	CHECK(simulator.transactions() == 1);
+	CHECK(charger.update());										//Data, sees the reset and asks to be called again
+	CHECK(simulator.transactions() == 2);
+	CHECK(charger.get_reset_count() == 1);
+	CHECK(callbacks == 0);
+	CHECK(charger.update() == false);								//The restore burst
+	CHECK(simulator.transactions() == 3);
+	CHECK(callbacks == 1 && lastRestored);
+	CHECK(deviceIchg() == 300);
+}
+void failedRestoreRetried() {										//Tried again on the next status read
+	start();
+	CHECK(charger.set_ichg(300));
+	simulator.reset();
+	simulator.fail_bursts = true;
+	charger.invalidate_status_cache();
+	charger.chg_stat();
+	CHECK(charger.get_reset_count() == 1);
+	CHECK(callbacks == 1 && lastRestored == false);
+	simulator.fail_bursts = false;
+	CHECK(charger.get_ichg() != 0);									//No status read, so no new attempt
+	CHECK(callbacks == 1);
+	charger.invalidate_status_cache();
+	charger.chg_stat();
+	CHECK(charger.get_reset_count() == 1);							//The same reset
+	CHECK(callbacks == 2 && lastRestored);
+	CHECK(deviceIchg() == 300);
+}
+void requestedResetNotUndone() {
+	start();
+	CHECK(charger.set_reg_rst(BQ25186_SOFTWARE_RESET));
+	uint16_t defaultIchg = deviceIchg();
+	CHECK(defaultIchg != 200);
+	charger.invalidate_status_cache();
+	charger.chg_stat();
+	CHECK(charger.get_reset_count() == 0);
+	CHECK(deviceIchg() == defaultIchg);
+	simulator.reset();												//A later reset restores the defaults the device was left at
+	charger.invalidate_status_cache();
+	charger.chg_stat();
+	CHECK(deviceIchg() == defaultIchg);
+}
+
+int main() {
+	laterWritesKept();
+	stagedChangesKept();
+	restoredBetweenUpdates();
+	failedRestoreRetried();
+	requestedResetNotUndone();
+	return bq25186_test_result("test_reset_detection");
+}
@@ -0,0 +1,174 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Checks bq25186_solar converges on the maximum power point of a simulated panel, follows it as the light changes and retries failed writes
+ *
+ *	g++ -std=gnu++11 -Isrc src/bq25186*.cpp tests/test_solar.cpp -o test_solar && ./test_solar
+ *
+ */
+
+#include "bq25186.h"
+#include "bq25186_simulator.h"
+#include "bq25186_solar.h"
+#include "bq25186_test.h"
+#include <math.h>
+
+class panel_simulator : public bq25186_simulator {					//A panel with the usual I-V curve, charging a battery that would take more than any ILIM
+
+	public:
+		uint16_t short_circuit_ma = 450;									//Scales with the light
+		uint16_t open_circuit_mv = 6000;
+		uint16_t knee_mv = 400;												//How sharply the current falls off towards open circuit
+		uint16_t demand_ma = 1200;											//What the battery and system would take
+		uint16_t vindpm_mv = 4500;
+		uint32_t power_uw = 0;												//Delivered at the last sample
+		bool fail_ilim_writes = false;
+		uint8_t write(uint8_t address, const uint8_t *data, uint8_t length, bool stop = true) override {
+			if(fail_ilim_writes && length == 2 && data[0] == 0x08) {
+				return BQ25186_BUS_NACK_DATA;
+			}
+			return bq25186_simulator::write(address, data, length, stop);
+		}
+		uint16_t current_at(uint16_t millivolts) {
+			double current = short_circuit_ma * (1 - exp((double(millivolts) - open_circuit_mv) / knee_mv));
+			return current > 0 ? uint16_t(current) : 0;
+		}
+		uint32_t power_at(uint16_t ilim) {									//Delivered with this ILIM, in µW
+			uint16_t draw = ilim < demand_ma ? ilim : demand_ma;
+			uint16_t available = current_at(vindpm_mv);
+			if(draw > available) {
+				return uint32_t(vindpm_mv) * available;						//The panel is held at VINDPM and gives what it can there
+			}
+			uint16_t millivolts = vindpm_mv;								//The panel sits above VINDPM where its current matches the draw
+			while(millivolts < open_circuit_mv && current_at(millivolts + 10) >= draw) {
+				millivolts += 10;
+			}
+			return uint32_t(millivolts) * draw;
+		}
+		uint16_t best_ilim_ma() {											//The highest ILIM setting the panel can supply at VINDPM
+			uint16_t available = current_at(vindpm_mv);
+			uint16_t best = 0;
+			for(uint8_t setting = 0; setting < 8; setting++) {
+				uint16_t ilim = bq25186::to_units(bq25186_units::ilim, bq25186_fields::ilim::from_code(setting));
+				if(ilim <= available && ilim > best) {
+					best = ilim;
+				}
+			}
+			return best;
+		}
+	protected:
+		void update_model_() override {
+			uint16_t ilim = bq25186::to_units(bq25186_units::ilim, peek(0x08) & BQ25186_I2C_BITMASK_2_0);
+			uint16_t draw = ilim < demand_ma ? ilim : demand_ma;
+			uint16_t available = current_at(vindpm_mv);
+			uint8_t status = BQ25186_CC_CHARGING | BQ25186_POWER_GOOD;
+			if(short_circuit_ma == 0) {
+				status = BQ25186_ENABLED_BUT_NOT_CHARGING;					//Dark, no input at all
+			} else if(draw > available) {
+				status |= BQ25186_VINDPM_ACTIVE;
+			} else if(ilim < demand_ma) {
+				status |= BQ25186_ILIM_ACTIVE;
+			}
+			power_uw = power_at(ilim);
+			set_status(0x00, status);
+		}
+};
+
+panel_simulator simulator;
+bq25186 charger;
+bq25186_solar tracker(charger);
+
+uint16_t trackerIlimMa() {
+	return bq25186::to_units(bq25186_units::ilim, tracker.get_ilim());
+}
+uint16_t runUntilSettled(uint16_t samples) {						//Samples until the tracker first reaches the best setting, 0xffff if it never does
+	uint16_t best = simulator.best_ilim_ma();
+	for(uint16_t sample = 0; sample < samples; sample++) {
+		tracker.update();
+		if(trackerIlimMa() == best) {
+			return sample;
+		}
+	}
+	return 0xffff;
+}
+void checkHolds(uint16_t samples) {								//In steady light it stays at the knee with only occasional probes
+	uint16_t best = simulator.best_ilim_ma();
+	uint32_t writes = tracker.get_writes();
+	uint16_t atBest = 0;
+	uint64_t power = 0;
+	for(uint16_t sample = 0; sample < samples; sample++) {
+		tracker.update();
+		CHECK(trackerIlimMa() >= best);								//Never backs off below the knee
+		if(trackerIlimMa() == best) {
+			atBest++;
+		}
+		power += simulator.power_uw;
+	}
+	CHECK(atBest * 10 >= samples * 9);
+	CHECK(tracker.get_writes() - writes <= samples / 10);
+	CHECK(power / samples * 100 >= uint64_t(simulator.power_at(best)) * 95);	//Within 5% of the best fixed ILIM
+}
+void flagsBetweenSamples() {										//Seen even when other code reads and clears them, and the application's counters don't matter
+	uint16_t best = simulator.best_ilim_ma();
+	tracker.set_hysteresis(1);										//Any flag, real or not, is a step
+	simulator.raise_flags(0x02, BQ25186_FLAG_VINDPM_ACTIVE >> 3);	//Register 0x02 is the upper bits of the flags
+	charger.invalidate_status_cache();
+	charger.take_faults();											//The application reads and clears it first
+	tracker.update();
+	CHECK(trackerIlimMa() < best);
+	CHECK(runUntilSettled(100) != 0xffff);
+	for(uint8_t sample = 0; sample < 20; sample++) {
+		charger.reset_fault_counts();
+		tracker.update();
+		CHECK(trackerIlimMa() >= best);
+	}
+	tracker.set_hysteresis(2);
+}
+void failedWriteRetried() {										//A failed write neither counts nor waits out the write interval
+	simulator.short_circuit_ma = 450;
+	tracker.set_min_write_interval(60e3);
+	CHECK(tracker.begin(BQ25186_VINDPM_4_5, BQ25186_ILIM_50_MA));
+	uint32_t writes = tracker.get_writes();
+	simulator.fail_ilim_writes = true;
+	tracker.update();
+	CHECK(tracker.update() == false);								//The step is due but the write fails
+	CHECK(tracker.get_writes() == writes);
+	CHECK(tracker.get_ilim() == BQ25186_ILIM_50_MA);
+	simulator.fail_ilim_writes = false;
+	CHECK(tracker.update());										//Tried again on the next sample, not a minute later
+	CHECK(tracker.get_writes() == writes + 1);
+	tracker.set_min_write_interval(0);
+}
+
+int main() {
+	CHECK(charger.begin(simulator));
+	tracker.set_sample_interval(0);									//Sample on every update()
+	tracker.set_min_write_interval(0);								//No limit, the samples are not in real time
+	tracker.set_hysteresis(2);
+	CHECK(tracker.begin(BQ25186_VINDPM_4_5, BQ25186_ILIM_50_MA));
+	CHECK(simulator.best_ilim_ma() == 400);
+	CHECK(runUntilSettled(100) != 0xffff);							//Climbs from 50mA
+	checkHolds(400);
+	flagsBetweenSamples();
+	simulator.short_circuit_ma = 700;								//Brighter
+	CHECK(simulator.best_ilim_ma() == 665);
+	CHECK(runUntilSettled(200) != 0xffff);
+	checkHolds(400);
+	simulator.short_circuit_ma = 150;								//Cloud
+	CHECK(simulator.best_ilim_ma() == 100);
+	CHECK(runUntilSettled(100) != 0xffff);
+	checkHolds(400);
+	simulator.short_circuit_ma = 0;									//Night, steps down to the minimum
+	for(uint16_t sample = 0; sample < 100; sample++) {
+		tracker.update();
+	}
+	CHECK(tracker.get_ilim() == BQ25186_ILIM_50_MA);
+	simulator.short_circuit_ma = 450;								//Morning
+	CHECK(runUntilSettled(100) != 0xffff);
+	failedWriteRetried();
+	return bq25186_test_result("test_solar");
+}
@@ -0,0 +1,96 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Checks the telemetry ring buffer keeps decoding as the oldest records are discarded, including records that fill the whole buffer
+ *
+ *	g++ -std=gnu++11 -Isrc src/bq25186*.cpp tests/test_telemetry.cpp -o test_telemetry && ./test_telemetry
+ *
+ */
+
+#include "bq25186.h"
+#include "bq25186_simulator.h"
+#include "bq25186_telemetry.h"
+#include "bq25186_test.h"
+
+uint16_t countEntries(const bq25186_telemetry &telemetry, bq25186_telemetry_entry &last) {
+	bq25186_telemetry_iterator iterator(telemetry);
+	uint16_t count = 0;
+	while(iterator.next(last)) {
+		count++;
+	}
+	return count;
+}
+void recordFillsBuffer() {											//Header, interval, three changed registers, samples and duration is exactly seven bytes
+	uint8_t buffer[7];
+	bq25186_telemetry telemetry(buffer, sizeof(buffer));
+	const uint8_t first[3] = {1, 2, 3};
+	const uint8_t second[3] = {4, 5, 6};
+	CHECK(telemetry.append(first, 0));
+	CHECK(telemetry.used() == 7);
+	CHECK(telemetry.append(second, 10));								//Replaces the first
+	CHECK(telemetry.entries() == 1);
+	CHECK(telemetry.used() == 7);
+	CHECK(telemetry.samples_discarded() == 1);
+	bq25186_telemetry_entry entry;
+	CHECK(countEntries(telemetry, entry) == 1);
+	CHECK(entry.timestamp == 10);
+	CHECK(entry.registers[0] == 4 && entry.registers[1] == 5 && entry.registers[2] == 6);
+	CHECK(telemetry.append(second, 20));								//Extending the run rewrites a trailer of the same length
+	CHECK(countEntries(telemetry, entry) == 1);
+	CHECK(entry.samples == 2 && entry.duration == 10);
+	CHECK(telemetry.append(second, 200) == false);					//A longer duration doesn't fit and the only run is never discarded to extend itself
+	CHECK(countEntries(telemetry, entry) == 1);
+	CHECK(entry.samples == 2 && entry.duration == 10);
+}
+void tooSmall() {
+	uint8_t buffer[4];
+	bq25186_telemetry telemetry(buffer, sizeof(buffer));
+	const uint8_t registers[3] = {1, 2, 3};
+	CHECK(telemetry.append(registers, 0) == false);
+	CHECK(telemetry.entries() == 0);
+	CHECK(telemetry.used() == 0);
+}
+void wrapsAround() {												//Many discards with records of different lengths
+	uint8_t buffer[32];
+	bq25186_telemetry telemetry(buffer, sizeof(buffer));
+	uint8_t registers[3] = {};
+	uint32_t timestamp = 0;
+	for(uint16_t index = 0; index < 1000; index++) {
+		registers[index % 3] = uint8_t(index);
+		timestamp += 1 + (index % 7) * 100;							//Intervals of one and two bytes
+		CHECK(telemetry.append(registers, timestamp));
+		if(index % 5 == 0) {
+			CHECK(telemetry.append(registers, timestamp + 1));		//Extend a run now and then
+		}
+		CHECK(telemetry.used() <= sizeof(buffer));
+	}
+	bq25186_telemetry_entry entry;
+	CHECK(countEntries(telemetry, entry) == telemetry.entries());
+	CHECK(entry.registers[0] == registers[0] && entry.registers[1] == registers[1] && entry.registers[2] == registers[2]);
+	CHECK(entry.timestamp == timestamp);
+}
+void sampleReportsAppend() {
+	bq25186_simulator simulator;
+	bq25186 charger;
+	CHECK(charger.begin(simulator));
+	uint8_t buffer[4];
+	bq25186_telemetry telemetry(buffer, sizeof(buffer));				//Too small for any record
+	simulator.set_status(0x00, BQ25186_CC_CHARGING | BQ25186_POWER_GOOD);
+	charger.invalidate_status_cache();
+	CHECK(telemetry.sample(charger) == false);
+	uint8_t larger[16];
+	bq25186_telemetry working(larger, sizeof(larger));
+	CHECK(working.sample(charger));
+}
+
+int main() {
+	recordFillsBuffer();
+	tooSmall();
+	wrapsAround();
+	sampleReportsAppend();
+	return bq25186_test_result("test_telemetry");
+}
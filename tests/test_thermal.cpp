@@ -0,0 +1,194 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Checks bq25186_thermal steps ICHG around a simulated thermal regulation threshold, holds while TS is warm or cool and falls back safely
+ *
+ *	g++ -std=gnu++11 -Isrc src/bq25186*.cpp tests/test_thermal.cpp -o test_thermal && ./test_thermal
+ *
+ */
+
+#include "bq25186.h"
+#include "bq25186_simulator.h"
+#include "bq25186_thermal.h"
+#include "bq25186_test.h"
+
+class die_simulator : public bq25186_simulator {					//The die reaches thermal regulation above a chosen charge current
+	public:
+		uint16_t thermreg_above_ma = 400;
+		uint8_t ts_stat = BQ25186_TS_NORMAL;
+		bool fail_reads = false;
+		bool fail_ichg_writes = false;
+		uint16_t ichg_ma() {												//As the register decodes, 1mA steps from 5mA then 10mA steps from 50mA
+			uint8_t code = peek(0x04) & BQ25186_I2C_BITMASK_6_0;
+			return code > 31 ? 40 + (code - 31) * 10 : code + 5;
+		}
+		uint8_t write(uint8_t address, const uint8_t *data, uint8_t length, bool stop = true) override {
+			if(fail_ichg_writes && length == 2 && data[0] == 0x04) {
+				return BQ25186_BUS_NACK_DATA;
+			}
+			return bq25186_simulator::write(address, data, length, stop);
+		}
+		uint8_t read(uint8_t address, uint8_t *data, uint8_t length, bool stop = true) override {
+			if(fail_reads) {
+				return BQ25186_BUS_NACK_ADDRESS;
+			}
+			return bq25186_simulator::read(address, data, length, stop);
+		}
+	protected:
+		void update_model_() override {
+			set_status(0x00, BQ25186_CC_CHARGING | BQ25186_POWER_GOOD | (ichg_ma() > thermreg_above_ma ? BQ25186_THERMREG_ACTIVE : 0));
+			set_status(0x01, ts_stat);
+		}
+};
+
+die_simulator simulator;
+bq25186 charger;
+bq25186_thermal governor(charger);
+
+void start() {
+	simulator.reset();
+	simulator.thermreg_above_ma = 400;
+	simulator.ts_stat = BQ25186_TS_NORMAL;
+	simulator.fail_reads = false;
+	simulator.fail_ichg_writes = false;
+	CHECK(charger.begin(simulator));
+	governor.set_sample_interval(0);								//Sample on every update()
+	governor.set_min_write_interval(0);								//No limit, the samples are not in real time
+	governor.set_step(10);
+	governor.set_hysteresis(3);
+	governor.set_safe_ichg(100);
+	CHECK(governor.begin(800));
+	CHECK(governor.get_ichg() == 100);								//Starts at the safe current and works up
+}
+uint16_t samplesUntilWrite(uint16_t samples) {						//Samples until update() changes ICHG, 0xffff if it never does
+	for(uint16_t sample = 1; sample <= samples; sample++) {
+		if(governor.update()) {
+			return sample;
+		}
+	}
+	return 0xffff;
+}
+void climbToRegulation() {											//Up from the safe current to the first step that regulates
+	while(governor.get_ichg() <= simulator.thermreg_above_ma && samplesUntilWrite(10) != 0xffff) {
+	}
+	CHECK(governor.get_ichg() == 410);
+}
+
+void stepsAroundThreshold() {
+	start();
+	CHECK(samplesUntilWrite(10) == 3);								//Three quiet samples before each step up
+	CHECK(governor.get_ichg() == 110);
+	climbToRegulation();
+	CHECK(samplesUntilWrite(1) == 1);								//Down two steps on the first sample that regulates
+	CHECK(governor.get_ichg() == 390);
+	CHECK(simulator.ichg_ma() == 390);
+	CHECK(samplesUntilWrite(10) == 3);								//Below the last regulation, so the usual hysteresis
+	CHECK(governor.get_ichg() == 400);
+	CHECK(samplesUntilWrite(20) == 3);								//Back up to where it regulated
+	CHECK(governor.get_ichg() == 410);
+	CHECK(samplesUntilWrite(1) == 1);
+	CHECK(samplesUntilWrite(10) == 3);
+	CHECK(samplesUntilWrite(20) == 6);								//The same ceiling again waits twice as long
+	CHECK(governor.get_ichg() == 410);
+	CHECK(samplesUntilWrite(1) == 1);
+	CHECK(samplesUntilWrite(10) == 3);
+	CHECK(samplesUntilWrite(20) == 12);
+	CHECK(governor.in_fallback() == false);
+}
+void latchedFlag() {												//Seen when other code reads and clears it, and the application's counters don't matter
+	start();
+	simulator.thermreg_above_ma = 1000;								//Never regulating live
+	CHECK(samplesUntilWrite(10) == 3);
+	CHECK(governor.get_ichg() == 110);
+	simulator.raise_flags(0x02, BQ25186_FLAG_THERMREG_ACTIVE >> 3);	//Register 0x02 is the upper bits of the flags
+	charger.invalidate_status_cache();
+	charger.take_faults();											//The application reads and clears it first
+	CHECK(samplesUntilWrite(1) == 1);
+	CHECK(governor.get_ichg() == 90);
+	for(uint8_t sample = 0; sample < 10; sample++) {
+		charger.reset_fault_counts();
+		CHECK(governor.update() == false || governor.get_ichg() > 90);	//Only ever steps up
+	}
+}
+void holdsWhileWarmOrCool() {										//The charger is already reducing the current
+	start();
+	simulator.ts_stat = BQ25186_TS_WARM;
+	CHECK(samplesUntilWrite(20) == 0xffff);
+	simulator.ts_stat = BQ25186_TS_COOL;
+	CHECK(samplesUntilWrite(20) == 0xffff);
+	CHECK(governor.get_ichg() == 100);
+	simulator.ts_stat = BQ25186_TS_NORMAL;
+	CHECK(samplesUntilWrite(10) == 3);								//The quiet count starts again
+	CHECK(governor.get_ichg() == 110);
+}
+void fallbackOnTs() {
+	start();
+	climbToRegulation();
+	uint32_t writes = governor.get_writes();
+	simulator.ts_stat = BQ25186_TS_TOO_HOT_OR_COLD;
+	CHECK(samplesUntilWrite(1) == 1);								//Straight away
+	CHECK(governor.in_fallback());
+	CHECK(simulator.ichg_ma() == 100);
+	CHECK(governor.get_writes() == writes + 1);
+	CHECK(samplesUntilWrite(10) == 0xffff);							//Stays there
+	simulator.ts_stat = BQ25186_TS_NORMAL;
+	CHECK(samplesUntilWrite(10) == 3);								//And works back up
+	CHECK(governor.in_fallback() == false);
+	CHECK(governor.get_ichg() == 110);
+}
+void fallbackOnFailedReads() {
+	start();
+	climbToRegulation();
+	simulator.fail_reads = true;
+	CHECK(governor.update() == false);
+	CHECK(governor.update() == false);
+	CHECK(governor.in_fallback() == false);
+	CHECK(governor.update());										//The third failure in a row
+	CHECK(governor.in_fallback());
+	CHECK(simulator.ichg_ma() == 100);
+	simulator.fail_reads = false;
+	CHECK(samplesUntilWrite(10) == 3);
+	CHECK(governor.in_fallback() == false);
+}
+void failedFallbackRetried() {										//Not in fallback until the safe current is written
+	start();
+	climbToRegulation();
+	uint32_t writes = governor.get_writes();
+	simulator.ts_stat = BQ25186_TS_TOO_HOT_OR_COLD;
+	simulator.fail_ichg_writes = true;
+	CHECK(governor.update() == false);
+	CHECK(governor.in_fallback() == false);
+	CHECK(governor.get_writes() == writes);							//A failed write isn't counted
+	CHECK(simulator.ichg_ma() == 410);
+	simulator.fail_ichg_writes = false;
+	CHECK(governor.update());										//The next sample tries again
+	CHECK(governor.in_fallback());
+	CHECK(simulator.ichg_ma() == 100);
+	simulator.ts_stat = BQ25186_TS_NORMAL;
+	CHECK(samplesUntilWrite(10) == 3);
+	climbToRegulation();
+	simulator.fail_reads = true;									//The same after three failed reads
+	simulator.fail_ichg_writes = true;
+	for(uint8_t sample = 0; sample < 4; sample++) {
+		CHECK(governor.update() == false);
+	}
+	CHECK(governor.in_fallback() == false);
+	simulator.fail_ichg_writes = false;
+	CHECK(governor.update());
+	CHECK(governor.in_fallback());
+	CHECK(simulator.ichg_ma() == 100);
+}
+
+int main() {
+	stepsAroundThreshold();
+	latchedFlag();
+	holdsWhileWarmOrCool();
+	fallbackOnTs();
+	fallbackOnFailedReads();
+	failedFallbackRetried();
+	return bq25186_test_result("test_thermal");
+}
@@ -0,0 +1,124 @@
+/*
+ *	An Arduino library to support the Texas Instruments BQ25186 (https://www.ti.com/product/BQ25186) "1A I²C-controlled linear battery charger with power path and solar input support"
+ *
+ *	https://github.com/ncmreynolds/bq25186
+ *
+ *	Released under LGPL-2.1 see https://github.com/ncmreynolds/bq25186/blob/main/LICENSE for full license
+ *
+ *	Several threads share one charger on bq25186_simulator while the worker is started and stopped, add -fsanitize=thread to also look for data races
+ *
+ *	g++ -std=gnu++11 -DBQ25186_THREAD_SAFE -pthread -Isrc src/bq25186*.cpp tests/test_thread_safe.cpp -o test_thread_safe && ./test_thread_safe
+ *
+ */
+
+#include "bq25186.h"
+#include "bq25186_simulator.h"
+#include "bq25186_test.h"
+#include <atomic>
+#include <thread>
+
+#if !defined BQ25186_THREAD_SAFE
+	#error "Build with -DBQ25186_THREAD_SAFE"
+#endif
+
+#define ITERATIONS 2000
+
+bq25186_simulator simulator;
+bq25186 charger;
+std::atomic<uint32_t> failures{0};
+std::atomic<uint32_t> queued{0};
+std::atomic<uint32_t> completed{0};
+
+void requestDone(bool success) {
+	completed++;
+	if(success == false) {
+		failures++;
+	}
+}
+void setIchg() {													//Each writer owns a register so its last value is known
+	for(uint16_t index = 0; index < ITERATIONS; index++) {
+		if(charger.set_ichg(index % 2 ? 100 : 200) == false) {
+			failures++;
+		}
+	}
+}
+void setVbatreg() {
+	for(uint16_t index = 0; index < ITERATIONS; index++) {
+		if(charger.set_vbatreg_mv(index % 2 ? 4100 : 4200) == false) {
+			failures++;
+		}
+	}
+}
+void readStatus() {
+	for(uint16_t index = 0; index < ITERATIONS; index++) {
+		charger.invalidate_status_cache();
+		if(charger.chg_stat() == BQ25186_I2C_ERROR) {
+			failures++;
+		}
+		uint8_t registers[0x0d];
+		if(charger.get_registers(0x00, sizeof(registers), registers) == false) {
+			failures++;
+		}
+	}
+}
+void queueReads() {
+	for(uint16_t index = 0; index < ITERATIONS; index++) {
+		if(charger.queue_read(0x00, 3, requestDone)) {
+			queued++;
+		} else {
+			std::this_thread::yield();								//Queue full, let the worker catch up
+		}
+	}
+}
+void faultSeen(uint8_t) {
+}
+void configure() {													//Settings the worker reads while it refreshes
+	for(uint16_t index = 0; index < ITERATIONS; index++) {
+		charger.set_config_cache_ttl(index % 2);
+		charger.set_status_cache_ttl(index % 3);
+		charger.set_fault_callback(index % 2 ? faultSeen : nullptr);
+		if(charger.get_last_error() != BQ25186_BUS_OK || charger.get_reset_count() != 0) {
+			failures++;
+		}
+	}
+}
+void restartWorker() {												//Stop and start while requests are queued
+	for(uint16_t index = 0; index < 50; index++) {
+		charger.stop_worker();
+		if(charger.start_worker() == false) {
+			failures++;
+		}
+	}
+}
+
+int main() {
+	CHECK(charger.begin(simulator));
+	CHECK(charger.start_worker());
+	CHECK(charger.start_worker() == false);							//Already running
+	std::thread threads[] = {std::thread(setIchg), std::thread(setVbatreg), std::thread(readStatus),
+		std::thread(queueReads), std::thread(configure), std::thread(restartWorker)};
+	for(std::thread &thread : threads) {
+		thread.join();
+	}
+	while(charger.async_busy()) {									//The worker finishes what is queued
+		std::this_thread::yield();
+	}
+	charger.stop_worker();
+	charger.stop_worker();											//Already stopped
+	CHECK(failures == 0);
+	CHECK(completed == queued);
+	CHECK(charger.get_ichg() == 100);								//The last value each writer set
+	CHECK(charger.get_vbatreg_mv() == 4100);
+	uint8_t cached[0x0d];
+	CHECK(charger.get_registers(0x03, 0x0a, cached));
+	for(uint8_t index = 0x03; index < 0x0d; index++) {				//The cache agrees with the device
+		CHECK(cached[index - 0x03] == simulator.peek(index));
+	}
+	{
+		bq25186 other;												//Destroyed with the worker running
+		CHECK(other.begin(simulator));
+		CHECK(other.start_worker());
+		CHECK(other.queue_read(0x00, 3));
+	}
+	return bq25186_test_result("test_thread_safe");
+}